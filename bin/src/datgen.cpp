@@ -13,6 +13,7 @@ int main(int argc, char **argv) {
 
     char* outputFileName = nullptr;
     bool fileNameConfigured = false;
+    char* inputFileName = nullptr; // Existing instance to convert
 
     // Program arguments
     for(int i = 0; i < argc; i++) {    
@@ -28,9 +29,19 @@ int main(int argc, char **argv) {
                     config.outputFormat = INSTANCE_OUT_FORMAT::SVG;
                 if(std::strcmp(argv[i+1], "ALL") == 0)
                     config.outputFormat = INSTANCE_OUT_FORMAT::ALL;
+                if(std::strcmp(argv[i+1], "BIN") == 0)
+                    config.outputFormat = INSTANCE_OUT_FORMAT::BIN;
+                if(std::strcmp(argv[i+1], "IDX") == 0)
+                    config.outputFormat = INSTANCE_OUT_FORMAT::IDX;
             }else
                 printHelp(MANUAL);
         }
+        if(strcmp(argv[i], "-i") == 0 || strcmp(argv[i], "--input") == 0) {
+            if(i+1 < argc)
+                inputFileName = argv[i+1];
+            else
+                printHelp(MANUAL);
+        }
         if(strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) {
             if(i+1 < argc) {
                 size_t len = strlen(argv[i+1]);
@@ -72,6 +83,9 @@ int main(int argc, char **argv) {
         if(strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--scaled") == 0){
             config.scaled = true;
         }
+        if(strcmp(argv[i], "-z") == 0 || strcmp(argv[i], "--sparse") == 0){
+            config.sparse = true;
+        }
         if(strcmp(argv[i], "-p") == 0 || strcmp(argv[i], "--positions") == 0) {
             if(i+1 < argc)
                 config.posDistribution = (POSDIST) atoi(argv[i+1]);
@@ -80,17 +94,21 @@ int main(int argc, char **argv) {
         }
     }
 
-    Instance* l = new Instance(config);
+    // Convert an existing instance file or generate a new one
+    Instance* l = inputFileName != nullptr ? new Instance(inputFileName) : new Instance(config);
 
 
     switch (config.outputFormat)
     {
     case INSTANCE_OUT_FORMAT::NONE:
-        l->printRawData();
+        if(config.sparse)
+            l->exportRawData(nullptr, true);
+        else
+            l->printRawData();
         break;
     case INSTANCE_OUT_FORMAT::TXT:
         if(fileNameConfigured)
-            l->exportRawData(outputFileName);
+            l->exportRawData(outputFileName, config.sparse);
         else
             std::cerr << "File name not set for TXT output format. Use -o filename" << std::endl;
         break;
@@ -106,9 +124,21 @@ int main(int argc, char **argv) {
         else
             std::cerr << "File name not set for SVG output format. Use -o filename" << std::endl;
         break;
+    case INSTANCE_OUT_FORMAT::BIN:
+        if(fileNameConfigured)
+            l->exportBinaryData(outputFileName, config.sparse);
+        else
+            std::cerr << "File name not set for BIN output format. Use -o filename" << std::endl;
+        break;
+    case INSTANCE_OUT_FORMAT::IDX: // Cache is linked to the input file
+        if(inputFileName != nullptr)
+            l->exportIndexCache(inputFileName);
+        else
+            std::cerr << "Input file not set for IDX output format. Use -i filename" << std::endl;
+        break;
     case INSTANCE_OUT_FORMAT::ALL:
         if(fileNameConfigured){
-            l->exportRawData(outputFileName);
+            l->exportRawData(outputFileName, config.sparse);
             l->generateHtmlPlot(outputFileName);
         }else
             std::cerr << "File name not set for ALL (HTML+TXT+SVG) output format. Use -o filename" << std::endl;
@@ -32,6 +32,7 @@ int main(int argc, char **argv) {
     config->stagnationWindow = 0.3;
 
     bool warmStart = false;
+    bool aggregate = false; // Merge identical EDs into weighted classes before solving
 
     OUTPUTFORMAT outputFormat = OUTPUTFORMAT::TXT;
 
@@ -61,6 +62,9 @@ int main(int argc, char **argv) {
                 std::cout << std::endl << "Error in argument -c (--cross)" << std::endl;
             }
         }
+        if(strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--aggregate") == 0){
+            aggregate = true;
+        }
         if(strcmp(argv[i], "-e") == 0 || strcmp(argv[i], "--elite") == 0){
             if(i+1 < argc)
                 config->elitismRate = atof(argv[i+1]);
@@ -182,6 +186,16 @@ int main(int argc, char **argv) {
         std::cout << std::endl << "Invalid instance model. Must specify --file or -f argument and file name." << std::endl << std::endl;
         exit(1);
     }
+
+    Instance *full = nullptr; // Instance with all the EDs, if solving the aggregated one
+    if(aggregate){
+        full = l;
+        #ifdef VERBOSE
+            l = full->aggregateEDs(true);
+        #else
+            l = full->aggregateEDs();
+        #endif
+    }
     
     #ifdef VERBOSE
         std::cout << "Input file loaded." << std::endl;
@@ -211,8 +225,12 @@ int main(int argc, char **argv) {
         std::string input;
         std::cout << "Reading population..." << std::endl;
         unsigned int popsize = 0;
+        bool streamed = false; // Input from "greedy --stream", the population can start before the stream ends
         while(std::cin >> input) {
-            if(input != "--"){
+            if(input[0] == '#'){ // Header of a streamed solution
+                streamed = true;
+                std::getline(std::cin, input);
+            }else if(input != "--"){
                 unsigned int gw = std::stoi(input);
                 unsigned int sf;
                 std::cin >> sf;
@@ -222,6 +240,10 @@ int main(int argc, char **argv) {
                 popsize++;
                 pop.push_back(network);
                 network.clear();
+                if(streamed && pop.size() >= config->populationSize){
+                    std::fclose(stdin); // Writer stops streaming instead of blocking on a full pipe
+                    break;
+                }
             }
         }
         std::cout << "Population read. Size: " << popsize << std::endl;
@@ -230,8 +252,8 @@ int main(int argc, char **argv) {
         std::vector<Chromosome*> population;
         for(uint k = 0; k < pop.size(); k++){ // For each network config (chromosome)
             AllocationChromosome* ch = new AllocationChromosome(o);
-            for(uint j = 0; j < pop[k].size(); j++){ // For each node (gene)
-                ch->setGeneValue(j, pop[k][j].gw, pop[k][j].sf);
+            for(uint j = 0; j < pop[k].size(); j++){ // For each node (gene). Genes of aggregated EDs take the last value of the class
+                ch->setGeneValue(l->getEDClass(j), pop[k][j].gw, pop[k][j].sf);
             }
             population.push_back(ch);
         }
@@ -254,6 +276,7 @@ int main(int argc, char **argv) {
     oResults.execTime = results.elapsed;
     oResults.cost = results.bestFitnessValue;
     oResults.ready = true;
+    oResults.stats = o->getStats();
     AllocationChromosome* bestChromosome = (AllocationChromosome*) results.best;
     bestChromosome->getPhenotype(oResults.cost, oResults.gwUsed, oResults.energy, oResults.uf, oResults.feasible);
     logResultsToCSV(oResults, LOGFILE);
@@ -270,6 +293,23 @@ int main(int argc, char **argv) {
         sf[i] = gene->getSF();
     }
 
+    Instance* aggregated = nullptr; // Still used by the chromosomes, deleted at the end
+    Objective* aggregatedObjective = nullptr;
+    if(full != nullptr){ // Each ED takes the allocation of its class
+        edCount = full->edCount;
+        uint* fullGW = new uint[edCount];
+        uint* fullSF = new uint[edCount];
+        l->expandSolution(gw, sf, fullGW, fullSF);
+        delete[] gw;
+        delete[] sf;
+        gw = fullGW;
+        sf = fullSF;
+        aggregated = l;
+        aggregatedObjective = o;
+        l = full;
+        o = new Objective(l, tp);
+    }
+
     if(xml){
         std::ofstream xmlOS(xmlFileName);
         o->exportWST(gw, sf, xmlOS);
@@ -287,5 +327,11 @@ int main(int argc, char **argv) {
         std::cout << "Total execution time = " << results.elapsed << " ms" << std::endl;
     }
 
+    if(full != nullptr){
+        delete o;
+        delete aggregatedObjective;
+        delete aggregated;
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -21,6 +21,7 @@ int main(int argc, char **argv) {
     TunningParameters tp; // alpha, beta and gamma
     bool verbose = false; // Disable printing to terminal
     bool wst = false; // Disable XML wst file export
+    bool reduce = false; // Remove dominated GWs before solving
     int method = 0; // Default is random search
     
     // Program arguments
@@ -107,11 +108,16 @@ int main(int argc, char **argv) {
                     method = 19;
                 else if(std::strcmp(argv[i+1], "G13") == 0)
                     method = 20;
+                else if(std::strcmp(argv[i+1], "HR") == 0)
+                    method = 21;
                 else 
                     std::cerr << "Unknown optimization method. Defaulting to RS" << std::endl;
             }else
                 printHelp(MANUAL);
         }
+        if(strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--reduce") == 0){
+            reduce = true;
+        }
         if(strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0){
             verbose = true;
         }
@@ -122,6 +128,12 @@ int main(int argc, char **argv) {
 
     if(l == nullptr) printHelp(MANUAL);
 
+    if(reduce){ // Solve without dominated GWs, results are printed with original GW indexes
+        Instance *reduced = l->reduceGateways(verbose);
+        delete l;
+        l = reduced;
+    }
+
     if(verbose) {    
         std::cout << "Input file loaded." << std::endl;
         std::cout << "GW Count: " << l->gwCount << std::endl;
@@ -187,6 +199,11 @@ int main(int argc, char **argv) {
             results.solverName = strdup("Greedy 8");
             break;
         }
+        case 21: {
+            results = heuristica_rod(l, o, maxIters, timeout, verbose, wst);
+            results.solverName = strdup("Heuristica Rod");
+            break;
+        }
         /*
         case 6: {
             results = greedy1(l, o, MIN::GW, verbose, wst);
@@ -269,6 +286,7 @@ int main(int argc, char **argv) {
     
     if(results.ready) {
         results.instanceName = l->getInstanceFileName();
+        results.stats = o->getStats();
         results.print();
         logResultsToCSV(results, LOGFILE);
     }
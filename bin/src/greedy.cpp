@@ -2,6 +2,7 @@
 #define LOGFILE "summary.csv"
 
 #include "lib/util/util.h"
+#include "lib/util/threadpool.h"
 #include "lib/model/instance.h"
 #include "lib/model/objective.h"
 #include "lib/optimization/greedy.h"
@@ -45,9 +46,13 @@ int main(int argc, char **argv) {
     bool printCsv = false; // CSV file export
     bool output = false; // Output to console
     unsigned int gaWarmStart = 0; // Number of solutions to export
+    bool reduce = false; // Remove dominated GWs before solving
+    bool aggregate = false; // Merge identical EDs into weighted classes before solving
+    uint threads = 0; // Threads for the allocation phase (0: sequential)
 
     char *xmlFileName;
     char *outputFileName;
+    char *streamFileName = nullptr; // Anytime output of solutions ("-" for stdout)
 
     // Clamp objective values (for gaWarmStart > 0)
     int maxen = 0;
@@ -75,6 +80,14 @@ int main(int argc, char **argv) {
             }
                 
         }
+        if(strcmp(argv[i], "--stream") == 0) {
+            if(i+1 < argc)
+                streamFileName = argv[i+1];
+            else{
+                std::cout << std::endl << "Error in argument --stream. File name required (- for standard output)" << std::endl;
+                printHelp(MANUAL);
+            }
+        }
         if(strcmp(argv[i], "--me") == 0) {
             if(i+1 < argc)
                 maxen = atoi(argv[i+1]);
@@ -117,6 +130,14 @@ int main(int argc, char **argv) {
                 std::cout << std::endl << "Error in argument -i (--iters)" << std::endl;
             }
         }
+        if(strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--threads") == 0) {
+            if(i+1 < argc) 
+                threads = atoi(argv[i+1]);
+            else{
+                printHelp(MANUAL);
+                std::cout << std::endl << "Error in argument -n (--threads)" << std::endl;
+            }
+        }
         if(strcmp(argv[i], "-a") == 0 || strcmp(argv[i], "--alpha") == 0){
             if(i+1 < argc)
                 tp.alpha = atof(argv[i+1]);
@@ -154,6 +175,12 @@ int main(int argc, char **argv) {
         if(strcmp(argv[i], "-x") == 0 || strcmp(argv[i], "--xcsv") == 0){
             printCsv = true;
         }
+        if(strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--reduce") == 0){
+            reduce = true;
+        }
+        if(strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--aggregate") == 0){
+            aggregate = true;
+        }
         if(strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0){
             if(i+1 < argc){
                 outputFileName = argv[i+1];
@@ -170,6 +197,26 @@ int main(int argc, char **argv) {
         std::cout << std::endl << "Invalid instance model. Must specify --file or -f argument and file name." << std::endl << std::endl;
         exit(1);
     }
+
+    if(reduce){ // Solve without dominated GWs, results are printed with original GW indexes
+        #ifdef VERBOSE
+            Instance *reduced = l->reduceGateways(true);
+        #else
+            Instance *reduced = l->reduceGateways();
+        #endif
+        delete l;
+        l = reduced;
+    }
+
+    Instance *full = nullptr; // Instance with all the EDs, if solving the aggregated one
+    if(aggregate){
+        full = l;
+        #ifdef VERBOSE
+            l = full->aggregateEDs(true);
+        #else
+            l = full->aggregateEDs();
+        #endif
+    }
     
     #ifdef VERBOSE
         std::cout << "Input file loaded." << std::endl;
@@ -179,6 +226,7 @@ int main(int argc, char **argv) {
             std::cout << " Timeout: " << timeout << " seconds." << std::endl;
             std::cout << " Stagnation limit: " << minImprovement << "\%" << std::endl;
             std::cout << " Max iterations: " << maxIterations << std::endl;
+        std::cout << "Threads: " << (threads == 0 ? 1 : threads) << std::endl;
         std::cout << "Tunning parameters:" << std::endl;
             std::cout << "  Alpha: " << tp.alpha << std::endl;
             std::cout << "  Beta: " << tp.beta << std::endl;
@@ -195,33 +243,32 @@ int main(int argc, char **argv) {
         std::cout << std::endl << "Step 2 -- Find and allocate essential nodes -- elapsed = " << getElapsed(start) << " sec." << std::endl;
     #endif
     Allocation bestAllocation(l); // Allocation (initially empty)
-    // Essential and non essential gw
-    std::unordered_set<uint> essGWSet; // Using set for unique values insertion
+    // Essential and non essential gw (from instance presolve)
+    const PresolveInfo& presolve = l->getPresolve();
+    if(!presolve.isFeasible()){
+        l->printPresolveReport();
+        std::cout << "Unfeasible system. Exiting program..." << std::endl;
+        exit(1);
+    }
+    std::vector<uint> essGW = presolve.essentialGWs;
     std::vector<uint> nEssGW;
     // Non essential nodes
     std::vector<uint> nEssED;
-    // Find essential gws and allocate essential nodes
+    // Allocate essential nodes
     std::vector<uint> reachGW; // This structure is used in following step
     for(uint e = 0; e < l->edCount; e++){
-        std::vector<uint> gwsOfE = l->getGWList(e);
-        if(gwsOfE.size() == 1){ // e is essential, add gw to essential gw list
-            essGWSet.insert(gwsOfE[0]);
+        const IndexSpan gwsOfE = l->getGWSpan(e);
+        if(gwsOfE.size() == 1){ // e is essential
             bestAllocation.checkUFAndConnect(e, gwsOfE[0]); // Connect node to essential gw
         }else{
             reachGW.push_back(gwsOfE.size()); // Add gw count of this non essential node
             nEssED.push_back(e);
         }
     }
-    std::vector<uint> essGW(essGWSet.begin(), essGWSet.end());
     // Initialize list of non essential gws
-    if(essGW.size() == 0){ // If no essential gws, initialize 
-        nEssGW.resize(l->gwCount);
-        std::iota(nEssGW.begin(), nEssGW.end(), 0);
-    }else{ // Add the other gws to non essential list
-        for(uint g = 0; g < l->gwCount; g++)
-            if(std::find(essGW.begin(), essGW.end(), g) == essGW.end())
-                nEssGW.push_back(g);
-    }
+    for(uint g = 0; g < l->gwCount; g++)
+        if(!l->isEssentialGW(g))
+            nEssGW.push_back(g);
 
     #ifdef VERBOSE
         std::cout << std::endl << "Essential GWs: " << essGW.size() << " (of " << l->gwCount << "):" << std::endl;
@@ -256,117 +303,245 @@ int main(int argc, char **argv) {
         std::cout << std::endl << "Step 4 -- Allocation of non essential nodes -- elapsed = " << getElapsed(start) << " sec." << std::endl;
     #endif
 
-    double minimumCost = __DBL_MAX__;
+    Incumbent incumbent; // Cost of bestAllocation
     bool timedout = false;
-    const Allocation essentials = bestAllocation;
+    Allocation tempAlloc = bestAllocation; // Essential nodes only
+    tempAlloc.beginJournal(); // Each construction is undone with reset(), without copying the allocation
+    CostBound essentialsBound(o); // Partial cost of the essential nodes, constructions stop when it reaches the incumbent
+    essentialsBound.reset(tempAlloc);
+    CostBound bound = essentialsBound;
+    std::vector<uint8_t> fits; // GWs that can take the current ED (allocation and reallocation)
     uint printed = 0; // Form GA warm start
-    for(uint s = 7; s <= 12; s++){
-
-        std::vector<std::vector<uint>> cluster;
-        // Build cluster for this SF
-        for (uint g = 0; g < l->gwCount; g++)
-            cluster.push_back(l->getAllEDList(g, s));
-        // Check if SF has coverage
-        bool hasCoverage = false;
-        for (uint ei = 0; ei < nEssED.size(); ei++) {
-            const uint e = nEssED[ei];
-            for (uint g = 0; g < l->gwCount; g++) {
-                auto it = std::find(cluster[g].begin(), cluster[g].end(), e);
-                hasCoverage = (it != cluster[g].end());
-                if(hasCoverage) break; // Next ED
-            }
-            if (!hasCoverage){
-                #ifdef VERBOSE    
-                    std::cout << "No coverage for SF " << s << ": ED " << e << " cannot be assigned to any GW." << std::endl;
-                #endif
-                break;
+
+    std::ofstream streamFile;
+    std::ostream* stream = nullptr; // Solutions are written as soon as they are found
+    if(streamFileName != nullptr){
+        if(strcmp(streamFileName, "-") == 0)
+            stream = &std::cout;
+        else{
+            streamFile.open(streamFileName);
+            if(!streamFile){
+                std::cerr << "Error: cannot open stream file " << streamFileName << std::endl;
+                exit(1);
             }
+            stream = &streamFile;
         }
-        if(!hasCoverage) continue; // Go to next SF
+        signal(SIGPIPE, SIG_IGN); // A reader that closes the pipe makes writes fail instead of killing the program
+    }
+    uint streamed = 0; // Sequence number of the streamed solutions
+
+    // Writes one line "gw sf" for each original ED and "--" after them, as read by the GA warm start. Streamed solutions
+    // start with a header line "# seq cost gw energy uf" and are flushed, so consumers do not wait for the end of the run
+    auto emit = [&](const Allocation& alloc, const EvalResults& res) {
+        std::ostream& os = stream != nullptr ? *stream : std::cout;
+        if(stream != nullptr)
+            os << "# " << streamed++ << " " << res.cost << " " << res.gwUsed << " " << res.energy << " " << res.uf << "\n";
+        for(uint e = 0; e < l->getOriginalEDCount(); e++){ // One line for each original ED
+            const uint c = l->getEDClass(e);
+            os << l->getOriginalGW(alloc.gw[c]) << " " << alloc.sf[c] << "\n";
+        }
+        os << "--" << std::endl;
+        if(stream != nullptr && !os) // Reader closed the pipe (or disk full), go on without streaming
+            stream = nullptr;
+    };
+
+    const ClusterIndex& clusters = l->getClusters();
+    const std::vector<uint64_t> nEssMask = clusters.getMask(nEssED);
+    auto checkCoverage = [&](uint s) { // Every non essential ED reaches some GW with SF lower than s
+        const uint e = clusters.firstUncovered(s, nEssMask);
         #ifdef VERBOSE
-            std::cout << "Coverage 100% reached at SF " << s << std::endl;
+            if(e < l->edCount)
+                std::cout << "No coverage for SF " << s << ": ED " << e << " cannot be assigned to any GW." << std::endl;
+            else
+                std::cout << "Coverage 100% reached at SF " << s << std::endl;
         #endif
-        
-        double improvement = 100.0;
-        for(uint i = 0; i < maxIterations; i++) {
+        return e == l->edCount;
+    };
+
+    // Connects the non essential EDs to the first GW of the shuffled lists (essential gws first) that can take them with
+    // SF lower than s. alloc and bound start from the essential nodes. Returns true if all EDs were connected
+    auto construct = [&](uint s, Allocation& alloc, CostBound& bound, const std::vector<uint>& essGW, const std::vector<uint>& nEssGW, 
+                        std::vector<uint8_t>& fits, const Incumbent& incumbent, bool prune, bool& pruned) {
+        alloc.reset();
+        bound = essentialsBound;
+        pruned = false;
+        for (uint ei = 0; ei < nEssED.size(); ei++) {
+            const uint e = nEssED[indirection[ei]]; // First nodes have less gws in range
+            // GWs of the cluster (min SF up to s-1) with enough UF for e
+            if(alloc.getFittingGWs(e, s-1, fits) > 0)
+                for (uint gi = 0; gi < l->gwCount; gi++) {
+                    // g is the index of gw from the arrays essGW or nEssGW
+                    const uint g = gi < essGW.size() ? essGW[gi] : nEssGW[gi - essGW.size()];
+                    if (fits[g]){ // First GW in the shuffled order
+                        const bool wasUsed = alloc.ufGW[g].isUsed();
+                        alloc.checkUFAndConnect(e, g);
+                        bound.connect(e, alloc.sf[e], alloc.ufGW[g], wasUsed);
+                        break; // Go to next ED
+                    }
+                }
+            if(!alloc.connected[e]) return false; // If a node cannot be connected, break ED loop --> next iter
+            if(prune && bound.exceeds(incumbent)){ // Cannot improve best allocation --> next iter
+                pruned = true;
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // Prints the allocation for the GA warm start and keeps it if it is the best one (streamed too). Returns true if the
+    // improvement is below the stagnation threshold (go to next SF)
+    auto accept = [&](uint s, uint i, const Allocation& alloc, const EvalResults& res, double& improvement) {
+        bool emitted = false;
+        if(gaWarmStart > 0 && printed < gaWarmStart){ // Print allocation
+            if(maxen > 0 && res.energy > maxen) return false; // Skip if energy > maxen
+            if(maxgw > 0 && res.gwUsed > maxgw) return false; // Skip if gw > maxgw
+            if(maxuf > 0 && res.uf > maxuf) return false; // Skip if uf > maxuf
+            emit(alloc, res);
+            emitted = true;
+            printed++;
+        }
 
-            if (isTimeout(start, (unsigned long int)timeout)) { // Check time limit
+        if(res.feasible && res.cost < incumbent.get()){ // New minimum found
+            if(stream != nullptr && !emitted) emit(alloc, res);
+            if(i > 0){ // Compute const improvement after first iteration
+                const double diff = incumbent.get() - res.cost;
+                improvement = round(diff/res.cost * 100);
+            }
+            #ifdef VERBOSE
+                std::cout << std::endl
+                    << "Iteration " << i << ". New best for SF = " << s  
+                    << ". Improvement = " << improvement << "\%" << std::endl;
+                if(i > 0) std::cout << "Prev Cost=" << incumbent.get() << ", New ";
+                o->printSolution(alloc, res, false, false, false);
+            #endif
+            incumbent.offer(res.cost);
+            bestAllocation = alloc;
+            if(improvement < minImprovement){
                 #ifdef VERBOSE
-                    std::cout << std::endl << "Time limit reached in allocation phase. Breaking phase." << std::endl;
+                    std::cout << std::endl 
+                            << "Improvement is below "  
+                            << minImprovement 
+                            << "\% in allocation phase. Breaking phase." 
+                            << std::endl;
                 #endif
-                timedout = true;
-                break; // for iter and then for sf
+                return true; // Next SF
             }
+        }
+        return false;
+    };
+
+    if(threads == 0){ // Sequential constructions with a single random generator
+        for(uint s = 7; s <= 12; s++){
+            if(!checkCoverage(s)) continue; // Go to next SF
             
-            // Shuffle list of essential and non-essential gws
-            std::shuffle(essGW.begin(), essGW.end(), gen); 
-            std::shuffle(nEssGW.begin(), nEssGW.end(), gen);
-            
-            // Start allocation of non essential EDs (essential gws first)
-            Allocation tempAlloc = essentials;
+            double improvement = 100.0;
+            for(uint i = 0; i < maxIterations; i++) {
 
-            for (uint ei = 0; ei < nEssED.size(); ei++) {
-                const uint e = nEssED[indirection[ei]]; // First nodes have less gws in range
-                for (uint gi = 0; gi < l->gwCount; gi++) {
-                    // g is the index of gw from the arrays essGW or nEssGW
-                    const uint g = gi < essGW.size() ? essGW[gi] : nEssGW[gi - essGW.size()];
-                    // Check if ED e can be connected to GW g
-                    auto it = std::find(cluster[g].begin(), cluster[g].end(), e);
-                    if (it != cluster[g].end())
-                        if(tempAlloc.checkUFAndConnect(e, g)) // If reachable, check uf and then connect
-                            break; // If connected, go to next ED
+                if (isTimeout(start, (unsigned long int)timeout)) { // Check time limit
+                    #ifdef VERBOSE
+                        std::cout << std::endl << "Time limit reached in allocation phase. Breaking phase." << std::endl;
+                    #endif
+                    timedout = true;
+                    break; // for iter and then for sf
+                }
+                
+                // Shuffle list of essential and non-essential gws
+                std::shuffle(essGW.begin(), essGW.end(), gen); 
+                std::shuffle(nEssGW.begin(), nEssGW.end(), gen);
+                
+                const bool prune = printed >= gaWarmStart; // Allocations for the GA warm start are printed regardless of their cost
+                bool pruned;
+                if(construct(s, tempAlloc, bound, essGW, nEssGW, fits, incumbent, prune, pruned)){ // If all nodes connected, eval solution
+                    const EvalResults res = o->eval(tempAlloc, false); // Use true to compute cost according to feasibility level
+                    if(accept(s, i, tempAlloc, res, improvement)) break; // Next SF
                 }
-                if(!tempAlloc.connected[e]) break; // If a node cannot be connected, break ED loop --> next iter
+                #ifdef VERBOSE
+                else if(pruned)
+                    std::cout << "SF " << s << ", iteration " << i << ", pruned after " << tempAlloc.connectedCount << " connected nodes (bound " << bound.get() << ")" << std::endl;
+                else // There are not connected nodes
+                    std::cout << "SF " << s << ", iteration " << i << ", connected nodes: " << tempAlloc.connectedCount << " (out of " << l->edCount << ")" << std::endl;
+                #endif
             }
 
-            // If all nodes connected, eval solution
-            if(tempAlloc.connectedCount == l->edCount){ 
-
-                EvalResults res = o->eval(tempAlloc, false); // Use true to compute cost according to feasibility level
-
-                if(gaWarmStart > 0 && printed < gaWarmStart){ // Print allocation
-                    if(maxen > 0 && res.energy > maxen) continue; // Skip if energy > maxen
-                    if(maxgw > 0 && res.gwUsed > maxgw) continue; // Skip if gw > maxgw
-                    if(maxuf > 0 && res.uf > maxuf) continue; // Skip if uf > maxuf
-                    for(uint e = 0; e < l->edCount; e++)
-                        std::cout << tempAlloc.gw[e] << " " << tempAlloc.sf[e] << std::endl;
-                    std::cout << "--" << std::endl;
-                    printed++;
+            if(timedout) break; // Do not go to next SF
+        }
+    }else{ 
+        // Constructions of all SF levels run in batches on a pool of threads. Each construction shuffles the GW lists
+        // with its own generator, seeded from (seed, SF, iteration), and uses its own allocation. Batches are reduced in
+        // the sequential order and prune with the incumbent of the previous batches, so results do not depend on threads
+        ThreadPool pool(threads);
+        const uint slots = pool.getThreadCount(); // Constructions per batch
+        const uint seed = gen();
+        std::vector<Allocation> slotAlloc(slots, tempAlloc);
+        std::vector<CostBound> slotBound(slots, essentialsBound);
+        std::vector<std::vector<uint8_t>> slotFits(slots);
+        std::vector<std::vector<uint>> slotEssGW(slots, essGW);
+        std::vector<std::vector<uint>> slotNEssGW(slots, nEssGW);
+        std::vector<EvalResults> slotRes(slots);
+        std::vector<uint8_t> slotState(slots); // 0: not run (time limit), 1: pruned or incomplete, 2: all nodes connected
+        std::vector<uint8_t> slotPruned(slots);
+        std::vector<size_t> batch(slots); // Index of the construction in tasks
+
+        std::vector<std::pair<uint, uint>> tasks; // (SF, iteration) of each construction, in sequential order
+        for(uint s = 7; s <= 12; s++)
+            if(checkCoverage(s))
+                for(uint i = 0; i < maxIterations; i++)
+                    tasks.push_back({s, i});
+        double improvement[13]; // Of each SF
+        bool stalled[13] = {false}; // SF stopped by the stagnation threshold
+        std::fill(improvement, improvement + 13, 100.0);
+
+        size_t next = 0;
+        while(next < tasks.size() && !timedout){
+            uint count = 0;
+            for(; count < slots && next < tasks.size(); next++)
+                if(!stalled[tasks[next].first])
+                    batch[count++] = next;
+            Incumbent batchIncumbent; // Same pruning for any thread count
+            batchIncumbent.offer(incumbent.get());
+            const bool prune = printed >= gaWarmStart; // Allocations for the GA warm start are printed regardless of their cost
+
+            pool.parallelFor(count, [&](uint k) {
+                slotState[k] = 0;
+                if (isTimeout(start, (unsigned long int)timeout)) return;
+                const uint s = tasks[batch[k]].first;
+                const uint i = tasks[batch[k]].second;
+                std::seed_seq seq{seed, s, i};
+                std::mt19937 rng(seq);
+                std::copy(essGW.begin(), essGW.end(), slotEssGW[k].begin());
+                std::copy(nEssGW.begin(), nEssGW.end(), slotNEssGW[k].begin());
+                std::shuffle(slotEssGW[k].begin(), slotEssGW[k].end(), rng); 
+                std::shuffle(slotNEssGW[k].begin(), slotNEssGW[k].end(), rng);
+                bool pruned;
+                slotState[k] = 1;
+                if(construct(s, slotAlloc[k], slotBound[k], slotEssGW[k], slotNEssGW[k], slotFits[k], batchIncumbent, prune, pruned)){
+                    slotRes[k] = o->eval(slotAlloc[k], false);
+                    slotState[k] = 2;
                 }
+                slotPruned[k] = pruned;
+            });
 
-                if(res.feasible && res.cost < minimumCost){ // New minimum found
-                    if(i > 0){ // Compute const improvement after first iteration
-                        const double diff = minimumCost - res.cost;
-                        improvement = round(diff/res.cost * 100);
-                    }
+            for(uint k = 0; k < count; k++){
+                const uint s = tasks[batch[k]].first;
+                const uint i = tasks[batch[k]].second;
+                if(slotState[k] == 0){ // Check time limit
                     #ifdef VERBOSE
-                        std::cout << std::endl
-                            << "Iteration " << i << ". New best for SF = " << s  
-                            << ". Improvement = " << improvement << "\%" << std::endl;
-                        if(i > 0) std::cout << "Prev Cost=" << minimumCost << ", New ";
-                        o->printSolution(tempAlloc, res, false, false, false);
+                        std::cout << std::endl << "Time limit reached in allocation phase. Breaking phase." << std::endl;
                     #endif
-                    minimumCost = res.cost;
-                    bestAllocation = tempAlloc;
-                    if(improvement < minImprovement){
-                        #ifdef VERBOSE
-                            std::cout << std::endl 
-                                    << "Improvement is below "  
-                                    << minImprovement 
-                                    << "\% in allocation phase. Breaking phase." 
-                                    << std::endl;
-                        #endif
-                        break; // Next SF
-                    }
+                    timedout = true;
+                    break;
                 }
+                if(stalled[s]) continue; // A previous construction of the batch stopped this SF
+                if(slotState[k] == 2)
+                    stalled[s] = accept(s, i, slotAlloc[k], slotRes[k], improvement[s]);
+                #ifdef VERBOSE
+                else if(slotPruned[k])
+                    std::cout << "SF " << s << ", iteration " << i << ", pruned after " << slotAlloc[k].connectedCount << " connected nodes (bound " << slotBound[k].get() << ")" << std::endl;
+                else // There are not connected nodes
+                    std::cout << "SF " << s << ", iteration " << i << ", connected nodes: " << slotAlloc[k].connectedCount << " (out of " << l->edCount << ")" << std::endl;
+                #endif
             }
-            #ifdef VERBOSE
-            else // There are not connected nodes
-                std::cout << "SF " << s << ", iteration " << i << ", connected nodes: " << tempAlloc.connectedCount << " (out of " << l->edCount << ")" << std::endl;
-            #endif
         }
-
-        if(timedout) break; // Do not go to next SF
     }
     // Eval objective function (to get number of GWs)
     EvalResults bestRes = o->eval(bestAllocation);
@@ -379,84 +554,55 @@ int main(int argc, char **argv) {
     #ifdef VERBOSE
         std::cout << std::endl << "Step 5 -- Reallocation -- elapsed = " << getElapsed(start) << " sec." << std::endl;
     #endif
-    Allocation tempAlloc = bestAllocation;
-
-    // Sort non essential GWs by number of EDs
-    std::vector<uint> usedGWList;
-    std::vector<std::vector<uint>> edsOfGW(bestRes.gwUsed); 
-    for (uint e = 0; e < l->edCount; e++) { // Traverse all nodes
-        const uint g = tempAlloc.gw[e];
-        auto it = std::find(usedGWList.begin(), usedGWList.end(), g); // Find gw of ED e
-        if (it != usedGWList.end()) { // If gw already in list, add its ED (e)
-            uint gwIndex = std::distance(usedGWList.begin(), it);
-            edsOfGW[gwIndex].push_back(e); // Add ED to GW
-        }else{ // If not, add
-            usedGWList.push_back(g); // Add gw index to list
-            edsOfGW[usedGWList.size() - 1].push_back(e); // Add first ED to gw
-        }
-    }
-
-    // Sort indirection array in ascending order of number of EDs
-    std::vector<uint> indirection2(bestRes.gwUsed);
-    std::iota(indirection2.begin(), indirection2.end(), 0);
-    std::sort(
-        indirection2.begin(),
-        indirection2.end(),
-        [&edsOfGW](const uint & a, const uint & b) {
-            return edsOfGW[a].size() < edsOfGW[b].size();
-        }
-    );
-    // Sort non essential GWs arrays by number of EDs
-    std::vector<uint> sortedUsedGWList(bestRes.gwUsed);
-    std::vector<std::vector<uint>> srtedGWbyEDs(bestRes.gwUsed);
-    for (uint gi = 0; gi < bestRes.gwUsed; gi++) {
-        const uint g = indirection2[gi];
-        sortedUsedGWList[gi] = usedGWList[g];
-        srtedGWbyEDs[gi] = edsOfGW[g];
-    }
-
-    // Start from first GW and try to connect all of its EDs to any of the following
-    uint reallocationCount = 0;
-	const uint nEssGWUsed = bestRes.gwUsed - essGW.size();
-    for (uint gi = 0; gi < nEssGWUsed; gi++) {
-        uint g1 = sortedUsedGWList[gi];    
-        for (uint ei = 0; ei < srtedGWbyEDs[gi].size(); ei++) { // For each ED of GW g
-            uint e = srtedGWbyEDs[gi][ei]; // Number of ED
-            std::vector<uint> availablesGWs = l->getGWList(e); // List of GW in range of this ED
-            for(long int gi2 = availablesGWs.size()-1; gi2 >= 0; gi2--){
-                const uint g2 = availablesGWs[gi2];
-                if(g2 != g1){
-                    auto it = std::find(sortedUsedGWList.begin(), sortedUsedGWList.end(), g2);
-                    if(it != sortedUsedGWList.end()){
-                        if(tempAlloc.checkUFAndMove(e, g2)){ // If moved e, remove from gw and sort arrays again
-                            #ifdef VERBOSE
-                                std::cout << "Reallocated ED " << e << ": GW " << g1 << " --> " << g2 << ", with new SF: " << tempAlloc.sf[e] << std::endl;
-                            #endif
-                            reallocationCount++;
-                            break;
-                        }
-                    }
-                }
-            }
-        }
-    }
-    
-    EvalResults tempRes = o->eval(tempAlloc);
-    if(tempRes.cost < bestRes.cost){
+    std::vector<uint> reallocGW(bestAllocation.gw);
+    std::vector<uint> reallocSF(bestAllocation.sf);
+    #ifdef VERBOSE
+        const uint reallocationCount = reallocate(l, o, reallocGW.data(), reallocSF.data(), true);
+    #else
+        const uint reallocationCount = reallocate(l, o, reallocGW.data(), reallocSF.data());
+    #endif
+    EvalResults tempRes = bestRes;
+    if(reallocationCount > 0){ // Only improving moves are applied
+        Allocation reallocated(l);
+        for(uint e = 0; e < l->edCount; e++)
+            reallocated.checkUFAndConnect(e, reallocGW[e], reallocSF[e]);
+        tempRes = o->eval(reallocated);
         #ifdef VERBOSE
-            std::cout << std::endl << "Reallocated " << reallocationCount << " nodes" << std::endl;
+            std::cout << std::endl << "Reallocation moves: " << reallocationCount << std::endl;
             std::cout << "Cost change after reallocation:" << std::endl;
             std::cout << "  GW = " << bestRes.gwUsed << " --> " << tempRes.gwUsed << std::endl;
             std::cout << "  E = " << bestRes.energy << " --> " << tempRes.energy << std::endl;
         #endif
-        bestAllocation = tempAlloc;
+        bestAllocation = reallocated;
         bestRes = tempRes;
+        if(stream != nullptr) emit(bestAllocation, bestRes);
     }else{
         #ifdef VERBOSE
             std::cout << "No improvement after reallocation" << std::endl;
         #endif
     }
 
+    const EvalStats stats = o->getStats(); // Evaluations of the solver, not of the final report
+
+    if(full != nullptr){ // Each ED takes the allocation of its class
+        std::vector<uint> gw(full->edCount);
+        std::vector<uint> sf(full->edCount);
+        l->expandSolution(bestAllocation.gw.data(), bestAllocation.sf.data(), gw.data(), sf.data());
+        Allocation expanded(full);
+        for(uint e = 0; e < full->edCount; e++)
+            expanded.checkUFAndConnect(e, gw[e], sf[e]);
+        delete o;
+        delete l;
+        l = full;
+        o = new Objective(l, tp);
+        bestAllocation = expanded;
+        bestRes = o->eval(bestAllocation);
+        if(expanded.connectedCount < full->edCount || !bestRes.feasible){
+            std::cerr << "Error: Expanded solution is not feasible (" << expanded.connectedCount << " of " << full->edCount << " EDs connected). Run without -d." << std::endl;
+            exit(1);
+        }
+    }
+
     #ifdef VERBOSE
         std::cout << std::endl << "Step 6 -- Print results -- elapsed = " << getElapsed(start) << " sec." << std::endl;
     #endif
@@ -465,11 +611,12 @@ int main(int argc, char **argv) {
     results.solverName = strdup("Greedy");
     results.tp = o->tp;
     results.execTime = getElapsedMs(start);
-    results.feasible = tempRes.feasible;
-    results.cost = tempRes.cost;
-    results.gwUsed = tempRes.gwUsed;
-    results.energy = tempRes.energy;
-    results.uf = tempRes.uf;
+    results.feasible = bestRes.feasible;
+    results.cost = bestRes.cost;
+    results.gwUsed = bestRes.gwUsed;
+    results.energy = bestRes.energy;
+    results.uf = bestRes.uf;
+    results.stats = stats;
     results.ready = true;
     if(gaWarmStart == 0){
         logResultsToCSV(results, LOGFILE);
@@ -484,9 +631,9 @@ int main(int argc, char **argv) {
         std::ofstream outputOS(outputFileName);
         o->printSolution(bestAllocation, bestRes, false, false, false, outputOS);
     }else if(printCsv){
-        std::cout << "Greedy," << results.instanceName  << ",-," << tempRes.gwUsed << "," << tempRes.energy << "," << tempRes.uf << std::endl;
+        std::cout << "Greedy," << results.instanceName  << ",-," << bestRes.gwUsed << "," << bestRes.energy << "," << bestRes.uf << std::endl;
     } else {
-        if(gaWarmStart == 0){
+        if(gaWarmStart == 0 && stream != &std::cout){ // Do not mix the report with the streamed solutions
             o->printSolution(bestAllocation, bestRes, false, false, false);
             std::cout << "Total execution time = " << results.execTime << " ms" << std::endl;
         }
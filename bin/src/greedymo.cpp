@@ -2,6 +2,7 @@
 #define LOGFILE "summary.csv"
 
 #include "lib/util/util.h"
+#include "lib/util/threadpool.h"
 #include "lib/model/instance.h"
 #include "lib/model/objective.h"
 #include "lib/optimization/greedy.h"
@@ -45,6 +46,8 @@ int main(int argc, char **argv) {
     bool printCsv = false; // CSV file export
     bool output = false; // Output to console
     unsigned int gaWarmStart = 0; // Number of solutions to export
+    bool reduce = false; // Remove dominated GWs before solving
+    uint threads = 0; // Threads for the allocation phase (0: sequential)
 
     char *xmlFileName;
     char *outputFileName;
@@ -95,6 +98,14 @@ int main(int argc, char **argv) {
                 std::cout << std::endl << "Error in argument -i (--iters)" << std::endl;
             }
         }
+        if(strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--threads") == 0) {
+            if(i+1 < argc) 
+                threads = atoi(argv[i+1]);
+            else{
+                printHelp(MANUAL);
+                std::cout << std::endl << "Error in argument -n (--threads)" << std::endl;
+            }
+        }
         if(strcmp(argv[i], "-a") == 0 || strcmp(argv[i], "--alpha") == 0){
             if(i+1 < argc)
                 tp.alpha = atof(argv[i+1]);
@@ -132,6 +143,9 @@ int main(int argc, char **argv) {
         if(strcmp(argv[i], "-x") == 0 || strcmp(argv[i], "--xcsv") == 0){
             printCsv = true;
         }
+        if(strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--reduce") == 0){
+            reduce = true;
+        }
         if(strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0){
             if(i+1 < argc){
                 outputFileName = argv[i+1];
@@ -148,6 +162,16 @@ int main(int argc, char **argv) {
         std::cout << std::endl << "Invalid instance model. Must specify --file or -f argument and file name." << std::endl << std::endl;
         exit(1);
     }
+
+    if(reduce){ // Solve without dominated GWs, results are printed with original GW indexes
+        #ifdef VERBOSE
+            Instance *reduced = l->reduceGateways(true);
+        #else
+            Instance *reduced = l->reduceGateways();
+        #endif
+        delete l;
+        l = reduced;
+    }
     
     #ifdef VERBOSE
         std::cout << "Input file loaded." << std::endl;
@@ -157,6 +181,7 @@ int main(int argc, char **argv) {
             std::cout << " Timeout: " << timeout << " seconds." << std::endl;
             std::cout << " Stagnation limit: " << minImprovement << "\%" << std::endl;
             std::cout << " Max iterations: " << maxIterations << std::endl;
+        std::cout << "Threads: " << (threads == 0 ? 1 : threads) << std::endl;
         std::cout << "Tunning parameters:" << std::endl;
             std::cout << "  Alpha: " << tp.alpha << std::endl;
             std::cout << "  Beta: " << tp.beta << std::endl;
@@ -173,33 +198,32 @@ int main(int argc, char **argv) {
         std::cout << std::endl << "Step 2 -- Find and allocate essential nodes -- elapsed = " << getElapsed(start) << " sec." << std::endl;
     #endif
     Allocation bestAllocation(l); // Allocation (initially empty)
-    // Essential and non essential gw
-    std::unordered_set<uint> essGWSet; // Using set for unique values insertion
+    // Essential and non essential gw (from instance presolve)
+    const PresolveInfo& presolve = l->getPresolve();
+    if(!presolve.isFeasible()){
+        l->printPresolveReport();
+        std::cout << "Unfeasible system. Exiting program..." << std::endl;
+        exit(1);
+    }
+    std::vector<uint> essGW = presolve.essentialGWs;
     std::vector<uint> nEssGW;
     // Non essential nodes
     std::vector<uint> nEssED;
-    // Find essential gws and allocate essential nodes
+    // Allocate essential nodes
     std::vector<uint> reachGW; // This structure is used in following step
     for(uint e = 0; e < l->edCount; e++){
-        std::vector<uint> gwsOfE = l->getGWList(e);
-        if(gwsOfE.size() == 1){ // e is essential, add gw to essential gw list
-            essGWSet.insert(gwsOfE[0]);
+        const IndexSpan gwsOfE = l->getGWSpan(e);
+        if(gwsOfE.size() == 1){ // e is essential
             bestAllocation.checkUFAndConnect(e, gwsOfE[0]); // Connect node to essential gw
         }else{
             reachGW.push_back(gwsOfE.size()); // Add gw count of this non essential node
             nEssED.push_back(e);
         }
     }
-    std::vector<uint> essGW(essGWSet.begin(), essGWSet.end());
     // Initialize list of non essential gws
-    if(essGW.size() == 0){ // If no essential gws, initialize 
-        nEssGW.resize(l->gwCount);
-        std::iota(nEssGW.begin(), nEssGW.end(), 0);
-    }else{ // Add the other gws to non essential list
-        for(uint g = 0; g < l->gwCount; g++)
-            if(std::find(essGW.begin(), essGW.end(), g) == essGW.end())
-                nEssGW.push_back(g);
-    }
+    for(uint g = 0; g < l->gwCount; g++)
+        if(!l->isEssentialGW(g))
+            nEssGW.push_back(g);
 
     #ifdef VERBOSE
         std::cout << std::endl << "Essential GWs: " << essGW.size() << " (of " << l->gwCount << "):" << std::endl;
@@ -236,113 +260,182 @@ int main(int argc, char **argv) {
 
     double minimumCost = __DBL_MAX__;
     bool timedout = false;
-    const Allocation essentials = bestAllocation;
+    Allocation tempAlloc = bestAllocation; // Essential nodes only
+    tempAlloc.beginJournal(); // Each construction is undone with reset(), without copying the allocation
+    std::vector<uint8_t> fits; // GWs that can take the current ED (allocation and reallocation)
     uint printed = 0; // Form GA warm start
-    for(uint s = 7; s <= 12; s++){
-
-        std::vector<std::vector<uint>> cluster;
-        // Build cluster for this SF
-        for (uint g = 0; g < l->gwCount; g++)
-            cluster.push_back(l->getAllEDList(g, s));
-        // Check if SF has coverage
-        bool hasCoverage = false;
-        for (uint ei = 0; ei < nEssED.size(); ei++) {
-            const uint e = nEssED[ei];
-            for (uint g = 0; g < l->gwCount; g++) {
-                auto it = std::find(cluster[g].begin(), cluster[g].end(), e);
-                hasCoverage = (it != cluster[g].end());
-                if(hasCoverage) break; // Next ED
-            }
-            if (!hasCoverage){
-                #ifdef VERBOSE    
-                    std::cout << "No coverage for SF " << s << ": ED " << e << " cannot be assigned to any GW." << std::endl;
-                #endif
-                break;
-            }
-        }
-        if(!hasCoverage) continue; // Go to next SF
+
+    const ClusterIndex& clusters = l->getClusters();
+    const std::vector<uint64_t> nEssMask = clusters.getMask(nEssED);
+    auto checkCoverage = [&](uint s) { // Every non essential ED reaches some GW with SF lower than s
+        const uint e = clusters.firstUncovered(s, nEssMask);
         #ifdef VERBOSE
-            std::cout << "Coverage 100% reached at SF " << s << std::endl;
+            if(e < l->edCount)
+                std::cout << "No coverage for SF " << s << ": ED " << e << " cannot be assigned to any GW." << std::endl;
+            else
+                std::cout << "Coverage 100% reached at SF " << s << std::endl;
         #endif
-        
-        double improvement = 100.0;
-        for(uint i = 0; i < maxIterations; i++) {
+        return e == l->edCount;
+    };
 
-            if (isTimeout(start, (unsigned long int)timeout)) { // Check time limit
-                #ifdef VERBOSE
-                    std::cout << std::endl << "Time limit reached in allocation phase. Breaking phase." << std::endl;
-                #endif
-                timedout = true;
-                break; // for iter and then for sf
-            }
-            
-            // Shuffle list of essential and non-essential gws
-            std::shuffle(essGW.begin(), essGW.end(), gen); 
-            std::shuffle(nEssGW.begin(), nEssGW.end(), gen);
-            
-            // Start allocation of non essential EDs (essential gws first)
-            Allocation tempAlloc = essentials;
-
-            for (uint ei = 0; ei < nEssED.size(); ei++) {
-                const uint e = nEssED[indirection[ei]]; // First nodes have less gws in range
+    // Connects the non essential EDs to the first GW of the shuffled lists (essential gws first) that can take them with
+    // SF lower than s. alloc starts from the essential nodes. Returns true if all EDs were connected
+    auto construct = [&](uint s, Allocation& alloc, const std::vector<uint>& essGW, const std::vector<uint>& nEssGW, std::vector<uint8_t>& fits) {
+        alloc.reset();
+        for (uint ei = 0; ei < nEssED.size(); ei++) {
+            const uint e = nEssED[indirection[ei]]; // First nodes have less gws in range
+            // GWs of the cluster (min SF up to s-1) with enough UF for e
+            if(alloc.getFittingGWs(e, s-1, fits) > 0)
                 for (uint gi = 0; gi < l->gwCount; gi++) {
                     // g is the index of gw from the arrays essGW or nEssGW
                     const uint g = gi < essGW.size() ? essGW[gi] : nEssGW[gi - essGW.size()];
-                    // Check if ED e can be connected to GW g
-                    auto it = std::find(cluster[g].begin(), cluster[g].end(), e);
-                    if (it != cluster[g].end())
-                        if(tempAlloc.checkUFAndConnect(e, g)) // If reachable, check uf and then connect
-                            break; // If connected, go to next ED
+                    if (fits[g]){ // First GW in the shuffled order
+                        alloc.checkUFAndConnect(e, g);
+                        break; // Go to next ED
+                    }
                 }
-                if(!tempAlloc.connected[e]) break; // If a node cannot be connected, break ED loop --> next iter
-            }
+            if(!alloc.connected[e]) return false; // If a node cannot be connected, break ED loop --> next iter
+        }
+        return true;
+    };
+
+    // Prints the allocation for the GA warm start and keeps it if it is the best one. Returns true if the improvement
+    // is below the stagnation threshold (go to next SF)
+    auto accept = [&](uint s, uint i, const Allocation& alloc, const EvalResults& res, double& improvement) {
+        if(gaWarmStart > 0 && printed < gaWarmStart){ // Print allocation
+            for(uint e = 0; e < l->edCount; e++)
+                std::cout << l->getOriginalGW(alloc.gw[e]) << " " << alloc.sf[e] << std::endl;
+            std::cout << "--" << std::endl;
+            printed++;
+        }
 
-            // If all nodes connected, eval solution
-            if(tempAlloc.connectedCount == l->edCount){ 
+        if(res.feasible && res.cost < minimumCost){ // New minimum found
+            if(i > 0){ // Compute const improvement after first iteration
+                const double diff = minimumCost - res.cost;
+                improvement = round(diff/res.cost * 100);
+            }
+            #ifdef VERBOSE
+                std::cout << std::endl
+                    << "Iteration " << i << ". New best for SF = " << s  
+                    << ". Improvement = " << improvement << "\%" << std::endl;
+                if(i > 0) std::cout << "Prev Cost=" << minimumCost << ", New ";
+                o->printSolution(alloc, res, false, false, false);
+            #endif
+            minimumCost = res.cost;
+            bestAllocation = alloc;
+            if(improvement < minImprovement){
+                #ifdef VERBOSE
+                    std::cout << std::endl 
+                            << "Improvement is below "  
+                            << minImprovement 
+                            << "\% in allocation phase. Breaking phase." 
+                            << std::endl;
+                #endif
+                return true; // Next SF
+            }
+        }
+        return false;
+    };
 
-                EvalResults res = o->eval(tempAlloc, false); // Use true to compute cost according to feasibility level
+    if(threads == 0){ // Sequential constructions with a single random generator
+        for(uint s = 7; s <= 12; s++){
+            if(!checkCoverage(s)) continue; // Go to next SF
+            
+            double improvement = 100.0;
+            for(uint i = 0; i < maxIterations; i++) {
 
+                if (isTimeout(start, (unsigned long int)timeout)) { // Check time limit
+                    #ifdef VERBOSE
+                        std::cout << std::endl << "Time limit reached in allocation phase. Breaking phase." << std::endl;
+                    #endif
+                    timedout = true;
+                    break; // for iter and then for sf
+                }
+                
+                // Shuffle list of essential and non-essential gws
+                std::shuffle(essGW.begin(), essGW.end(), gen); 
+                std::shuffle(nEssGW.begin(), nEssGW.end(), gen);
+                
+                if(construct(s, tempAlloc, essGW, nEssGW, fits)){ // If all nodes connected, eval solution
+                    const EvalResults res = o->eval(tempAlloc, false); // Use true to compute cost according to feasibility level
+                    if(accept(s, i, tempAlloc, res, improvement)) break; // Next SF
+                }
+                #ifdef VERBOSE
+                else // There are not connected nodes
+                    std::cout << "SF " << s << ", iteration " << i << ", connected nodes: " << tempAlloc.connectedCount << " (out of " << l->edCount << ")" << std::endl;
+                #endif
+            }
 
-                if(gaWarmStart > 0 && printed < gaWarmStart){ // Print allocation
-                    for(uint e = 0; e < l->edCount; e++)
-                        std::cout << tempAlloc.gw[e] << " " << tempAlloc.sf[e] << std::endl;
-                    std::cout << "--" << std::endl;
-                    printed++;
+            if(timedout) break; // Do not go to next SF
+        }
+    }else{ 
+        // Constructions of all SF levels run in batches on a pool of threads. Each construction shuffles the GW lists
+        // with its own generator, seeded from (seed, SF, iteration), and uses its own allocation. Batches are reduced
+        // in the sequential order, so results do not depend on the number of threads
+        ThreadPool pool(threads);
+        const uint slots = pool.getThreadCount(); // Constructions per batch
+        const uint seed = gen();
+        std::vector<Allocation> slotAlloc(slots, tempAlloc);
+        std::vector<std::vector<uint8_t>> slotFits(slots);
+        std::vector<std::vector<uint>> slotEssGW(slots, essGW);
+        std::vector<std::vector<uint>> slotNEssGW(slots, nEssGW);
+        std::vector<EvalResults> slotRes(slots);
+        std::vector<uint8_t> slotState(slots); // 0: not run (time limit), 1: incomplete, 2: all nodes connected
+        std::vector<size_t> batch(slots); // Index of the construction in tasks
+
+        std::vector<std::pair<uint, uint>> tasks; // (SF, iteration) of each construction, in sequential order
+        for(uint s = 7; s <= 12; s++)
+            if(checkCoverage(s))
+                for(uint i = 0; i < maxIterations; i++)
+                    tasks.push_back({s, i});
+        double improvement[13]; // Of each SF
+        bool stalled[13] = {false}; // SF stopped by the stagnation threshold
+        std::fill(improvement, improvement + 13, 100.0);
+
+        size_t next = 0;
+        while(next < tasks.size() && !timedout){
+            uint count = 0;
+            for(; count < slots && next < tasks.size(); next++)
+                if(!stalled[tasks[next].first])
+                    batch[count++] = next;
+
+            pool.parallelFor(count, [&](uint k) {
+                slotState[k] = 0;
+                if (isTimeout(start, (unsigned long int)timeout)) return;
+                const uint s = tasks[batch[k]].first;
+                const uint i = tasks[batch[k]].second;
+                std::seed_seq seq{seed, s, i};
+                std::mt19937 rng(seq);
+                std::copy(essGW.begin(), essGW.end(), slotEssGW[k].begin());
+                std::copy(nEssGW.begin(), nEssGW.end(), slotNEssGW[k].begin());
+                std::shuffle(slotEssGW[k].begin(), slotEssGW[k].end(), rng); 
+                std::shuffle(slotNEssGW[k].begin(), slotNEssGW[k].end(), rng);
+                slotState[k] = 1;
+                if(construct(s, slotAlloc[k], slotEssGW[k], slotNEssGW[k], slotFits[k])){
+                    slotRes[k] = o->eval(slotAlloc[k], false);
+                    slotState[k] = 2;
                 }
+            });
 
-                if(res.feasible && res.cost < minimumCost){ // New minimum found
-                    if(i > 0){ // Compute const improvement after first iteration
-                        const double diff = minimumCost - res.cost;
-                        improvement = round(diff/res.cost * 100);
-                    }
+            for(uint k = 0; k < count; k++){
+                const uint s = tasks[batch[k]].first;
+                const uint i = tasks[batch[k]].second;
+                if(slotState[k] == 0){ // Check time limit
                     #ifdef VERBOSE
-                        std::cout << std::endl
-                            << "Iteration " << i << ". New best for SF = " << s  
-                            << ". Improvement = " << improvement << "\%" << std::endl;
-                        if(i > 0) std::cout << "Prev Cost=" << minimumCost << ", New ";
-                        o->printSolution(tempAlloc, res, false, false, false);
+                        std::cout << std::endl << "Time limit reached in allocation phase. Breaking phase." << std::endl;
                     #endif
-                    minimumCost = res.cost;
-                    bestAllocation = tempAlloc;
-                    if(improvement < minImprovement){
-                        #ifdef VERBOSE
-                            std::cout << std::endl 
-                                    << "Improvement is below "  
-                                    << minImprovement 
-                                    << "\% in allocation phase. Breaking phase." 
-                                    << std::endl;
-                        #endif
-                        break; // Next SF
-                    }
+                    timedout = true;
+                    break;
                 }
+                if(stalled[s]) continue; // A previous construction of the batch stopped this SF
+                if(slotState[k] == 2)
+                    stalled[s] = accept(s, i, slotAlloc[k], slotRes[k], improvement[s]);
+                #ifdef VERBOSE
+                else // There are not connected nodes
+                    std::cout << "SF " << s << ", iteration " << i << ", connected nodes: " << slotAlloc[k].connectedCount << " (out of " << l->edCount << ")" << std::endl;
+                #endif
             }
-            #ifdef VERBOSE
-            else // There are not connected nodes
-                std::cout << "SF " << s << ", iteration " << i << ", connected nodes: " << tempAlloc.connectedCount << " (out of " << l->edCount << ")" << std::endl;
-            #endif
         }
-
-        if(timedout) break; // Do not go to next SF
     }
     // Eval objective function (to get number of GWs)
     EvalResults bestRes = o->eval(bestAllocation);
@@ -355,77 +448,26 @@ int main(int argc, char **argv) {
     #ifdef VERBOSE
         std::cout << std::endl << "Step 5 -- Reallocation -- elapsed = " << getElapsed(start) << " sec." << std::endl;
     #endif
-    Allocation tempAlloc = bestAllocation;
-
-    // Sort non essential GWs by number of EDs
-    std::vector<uint> usedGWList;
-    std::vector<std::vector<uint>> edsOfGW(bestRes.gwUsed); 
-    for (uint e = 0; e < l->edCount; e++) { // Traverse all nodes
-        const uint g = tempAlloc.gw[e];
-        auto it = std::find(usedGWList.begin(), usedGWList.end(), g); // Find gw of ED e
-        if (it != usedGWList.end()) { // If gw already in list, add its ED (e)
-            uint gwIndex = std::distance(usedGWList.begin(), it);
-            edsOfGW[gwIndex].push_back(e); // Add ED to GW
-        }else{ // If not, add
-            usedGWList.push_back(g); // Add gw index to list
-            edsOfGW[usedGWList.size() - 1].push_back(e); // Add first ED to gw
-        }
-    }
-
-    // Sort indirection array in ascending order of number of EDs
-    std::vector<uint> indirection2(bestRes.gwUsed);
-    std::iota(indirection2.begin(), indirection2.end(), 0);
-    std::sort(
-        indirection2.begin(),
-        indirection2.end(),
-        [&edsOfGW](const uint & a, const uint & b) {
-            return edsOfGW[a].size() < edsOfGW[b].size();
-        }
-    );
-    // Sort non essential GWs arrays by number of EDs
-    std::vector<uint> sortedUsedGWList(bestRes.gwUsed);
-    std::vector<std::vector<uint>> srtedGWbyEDs(bestRes.gwUsed);
-    for (uint gi = 0; gi < bestRes.gwUsed; gi++) {
-        const uint g = indirection2[gi];
-        sortedUsedGWList[gi] = usedGWList[g];
-        srtedGWbyEDs[gi] = edsOfGW[g];
-    }
-
-    // Start from first GW and try to connect all of its EDs to any of the following
-    uint reallocationCount = 0;
-	const uint nEssGWUsed = bestRes.gwUsed - essGW.size();
-    for (uint gi = 0; gi < nEssGWUsed; gi++) {
-        uint g1 = sortedUsedGWList[gi];    
-        for (uint ei = 0; ei < srtedGWbyEDs[gi].size(); ei++) { // For each ED of GW g
-            uint e = srtedGWbyEDs[gi][ei]; // Number of ED
-            std::vector<uint> availablesGWs = l->getGWList(e); // List of GW in range of this ED
-            for(long int gi2 = availablesGWs.size()-1; gi2 >= 0; gi2--){
-                const uint g2 = availablesGWs[gi2];
-                if(g2 != g1){
-                    auto it = std::find(sortedUsedGWList.begin(), sortedUsedGWList.end(), g2);
-                    if(it != sortedUsedGWList.end()){
-                        if(tempAlloc.checkUFAndMove(e, g2)){ // If moved e, remove from gw and sort arrays again
-                            #ifdef VERBOSE
-                                std::cout << "Reallocated ED " << e << ": GW " << g1 << " --> " << g2 << ", with new SF: " << tempAlloc.sf[e] << std::endl;
-                            #endif
-                            reallocationCount++;
-                            break;
-                        }
-                    }
-                }
-            }
-        }
-    }
-    
-    EvalResults tempRes = o->eval(tempAlloc);
-    if(tempRes.cost < bestRes.cost){
+    std::vector<uint> reallocGW(bestAllocation.gw);
+    std::vector<uint> reallocSF(bestAllocation.sf);
+    #ifdef VERBOSE
+        const uint reallocationCount = reallocate(l, o, reallocGW.data(), reallocSF.data(), true);
+    #else
+        const uint reallocationCount = reallocate(l, o, reallocGW.data(), reallocSF.data());
+    #endif
+    EvalResults tempRes = bestRes;
+    if(reallocationCount > 0){ // Only improving moves are applied
+        Allocation reallocated(l);
+        for(uint e = 0; e < l->edCount; e++)
+            reallocated.checkUFAndConnect(e, reallocGW[e], reallocSF[e]);
+        tempRes = o->eval(reallocated);
         #ifdef VERBOSE
-            std::cout << std::endl << "Reallocated " << reallocationCount << " nodes" << std::endl;
+            std::cout << std::endl << "Reallocation moves: " << reallocationCount << std::endl;
             std::cout << "Cost change after reallocation:" << std::endl;
             std::cout << "  GW = " << bestRes.gwUsed << " --> " << tempRes.gwUsed << std::endl;
             std::cout << "  E = " << bestRes.energy << " --> " << tempRes.energy << std::endl;
         #endif
-        bestAllocation = tempAlloc;
+        bestAllocation = reallocated;
         bestRes = tempRes;
     }else{
         #ifdef VERBOSE
@@ -446,6 +488,7 @@ int main(int argc, char **argv) {
     results.gwUsed = tempRes.gwUsed;
     results.energy = tempRes.energy;
     results.uf = tempRes.uf;
+    results.stats = o->getStats();
     results.ready = true;
     if(gaWarmStart == 0){
         logResultsToCSV(results, LOGFILE);
@@ -17,7 +17,7 @@ class Chromosome { // Abstract class that models a chromosome (list of genes wit
 
         virtual std::string getName() const = 0;
 
-        inline std::vector<Gene*> getGenes() const { return genes; }
+        inline const std::vector<Gene*>& getGenes() const { return genes; }
         inline void setGenes(std::vector<Gene*> genes) { this->genes = genes; }
 
         virtual void printGenotype() const;
@@ -16,6 +16,11 @@ class Fitness { // Abstract class that models a fitness function
         virtual ~Fitness() = default;
         virtual std::string getName() const = 0;        
         virtual void evaluate(Chromosome *chromosome) const = 0;
+        virtual void evaluateBatch(const std::vector<Chromosome*>& chromosomes) const { // Override to evaluate many at once
+            for (Chromosome* chromosome : chromosomes)
+                evaluate(chromosome);
+        }
+        virtual void evaluateObjectives(Chromosome *chromosome) const {} // Override if evaluate skips objectives that are only reported
         virtual Chromosome* generateChromosome(CROSS_METHOD cm) const = 0;
 
     protected:
@@ -3,6 +3,8 @@
 GeneticAlgorithm::GeneticAlgorithm() { 
     // Initialize with default configuration
     config = new GAConfig();
+    evaluations = 0;
+    evaluationTime = 0.0;
     // Cannot initialize with default constructor
 }
 
@@ -10,6 +12,8 @@ GeneticAlgorithm::GeneticAlgorithm(Fitness *fitnessFunction, GAConfig *config) {
     // Initialize with a fitness function and configuration
     this->config = config;
     this->fitnessFunction = fitnessFunction;
+    evaluations = 0;
+    evaluationTime = 0.0;
     initialize();
 }
 
@@ -73,10 +77,17 @@ void GeneticAlgorithm::clearPopulation() {
     population.clear();
 }
 
+void GeneticAlgorithm::evaluatePopulation() {
+    auto start = std::chrono::high_resolution_clock::now();
+    fitnessFunction->evaluateBatch(population);
+    evaluationTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    evaluations += population.size();
+}
+
 void GeneticAlgorithm::evaluation() {
     long int bestFitnessIndex = -1;
+    evaluatePopulation();
     for (unsigned int i = 0; i < config->populationSize; i++) {
-        fitnessFunction->evaluate(population[i]);
         if(population[i]->fitness > bestFitnessValue){
             //std::cout << "New best fitness: " << population[i]->fitness << std::endl;
             bestFitnessValue = population[i]->fitness;
@@ -199,6 +210,8 @@ GAResults GeneticAlgorithm::run() {
     bestFitnessValue = __DBL_MIN__;
     currentGeneration = 0;
     stagnatedGenerations = 0;
+    evaluations = 0;
+    evaluationTime = 0.0;
     unsigned int maxStagationGenerations = config->stagnationWindow*config->maxGenerations;
     
 
@@ -240,11 +253,14 @@ GAResults GeneticAlgorithm::run() {
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start); // Convert to milliseconds
 
     // Export results
+    fitnessFunction->evaluateObjectives(bestChromosome);
     results.status = status;
     results.best = bestChromosome;
     results.bestFitnessValue = bestChromosome->fitness;
     results.generations = currentGeneration;
     results.elapsed = static_cast<int>(duration.count());
+    results.evaluations = evaluations;
+    results.evaluationTime = evaluationTime;
 
     /*
     for (unsigned int i = 0; i < config->populationSize; i++) {
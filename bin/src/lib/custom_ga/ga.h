@@ -49,6 +49,10 @@ class GeneticAlgorithm {
 
         unsigned int currentGeneration;
         unsigned int stagnatedGenerations;
+        unsigned long long evaluations; // Counted by evaluation(), reset by run()
+        double evaluationTime; // ms
+
+        void evaluatePopulation(); // Evaluates the population and updates the counters
 
         virtual void sortPopulation();
         void initialize();
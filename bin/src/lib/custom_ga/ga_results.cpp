@@ -7,6 +7,8 @@ GAResults::GAResults(OBJTYPE type) {
     generations = 0;
     status = STATUS::IDLE;
     elapsed = 0;
+    evaluations = 0;
+    evaluationTime = 0.0;
     outputFormat = OUTPUTFORMAT::TXT;
 
     OutputStream os(STREAM::CONSOLE);
@@ -16,6 +18,8 @@ GAResults::GAResults(OBJTYPE type) {
 void GAResults::printStats() {
     *outputStream << std::endl << "Generations: " << generations << std::endl;
     *outputStream << "Elapsed time: " << elapsed << "ms" << std::endl;
+    *outputStream << "Evaluations: " << evaluations << " (" << (elapsed > 0 ? evaluations * 1000.0 / elapsed : 0) << " per second)" << std::endl;
+    *outputStream << "Evaluation time: " << evaluationTime << "ms" << std::endl;
     *outputStream << "Stop condition: ";
     switch (status) {
         case STATUS::IDLE:
@@ -30,6 +30,8 @@ class GAResults { // Results of the Genetic Algorithm
         std::vector<Chromosome*> paretoFront;
         STATUS status;
         int elapsed;
+        unsigned long long evaluations; // Chromosomes evaluated by the fitness function during the run
+        double evaluationTime; // ms
         std::ostream *outputStream;
         OUTPUTFORMAT outputFormat;
 
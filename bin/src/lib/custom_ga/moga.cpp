@@ -53,9 +53,7 @@ void MultiObjectiveGA::sortPopulation() { // Non-dominated sorting
 }
 
 void MultiObjectiveGA::evaluation() {
-    for (unsigned int i = 0; i < config->populationSize; i++) {
-        fitnessFunction->evaluate(population[i]);
-    }
+    evaluatePopulation();
 }
 
 void MultiObjectiveGA::selection() { // Crowding distance
@@ -151,6 +149,8 @@ GAResults MultiObjectiveGA::run() { // Try to avoid overriding this method
 
     status = STATUS::RUNNING;
     currentGeneration = 0;
+    evaluations = 0;
+    evaluationTime = 0.0;
     
     // Start the timer
     auto start = std::chrono::high_resolution_clock::now();
@@ -189,6 +189,8 @@ GAResults MultiObjectiveGA::run() { // Try to avoid overriding this method
     results.paretoFront = paretoFronts[0];
     results.generations = currentGeneration;
     results.elapsed = static_cast<int>(duration.count());
+    results.evaluations = evaluations;
+    results.evaluationTime = evaluationTime;
 
     return results;
 }
\ No newline at end of file
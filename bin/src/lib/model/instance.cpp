@@ -3,50 +3,431 @@
 const uint Instance::pw[6] = {1, 2, 4, 8, 16, 32}; // Time window values for spread factors
 
 Instance::Instance(char* filename) {
-    std::ifstream file(filename);
-    if (!file) {
+    this->mappedFile = nullptr;
+    this->mappedSize = 0;
+    this->sfMatrix = nullptr;
+    this->sfMatrixT = nullptr;
+    this->adjOffsets = nullptr;
+    this->adjGW = nullptr;
+    this->adjSF = nullptr;
+    this->originalGWCount = 0;
+    this->outputFormat = INSTANCE_OUT_FORMAT::NONE;
+
+    if(!this->loadBinaryFile(filename)) // Binary files are mapped, otherwise parse as text
+        this->loadTextFile(filename);
+    if(this->sfMatrixT == nullptr && !this->isSparse()) // Not included in file
+        this->buildTranspose();
+    this->buildTables();
+    const std::string cacheFileName = std::string(filename) + INDEX_CACHE_EXTENSION;
+    if(!this->loadIndexCache(cacheFileName.c_str())){ // Missing or outdated cache
+        this->buildIndexes();
+        this->presolve();
+    }
+
+    this->instanceFileName = new char[strlen(filename) + 1];
+    strcpy(this->instanceFileName, extractFileName(filename));
+}
+
+static inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static const char* parseRow(const char* p, const char* end, uint8_t* row, uint32_t& period, uint gwCount, uint& col) {
+    // Parses the values of one line into the matrix row. Returns pointer to the next line
+    col = 0;
+    while (p < end && *p != '\n') {
+        if (isBlank(*p)) { p++; continue; }
+        uint number;
+        std::from_chars_result res = std::from_chars(p, end, number);
+        if (res.ec != std::errc()) { // Not a number, skip token and report the row as invalid
+            while (p < end && *p != '\n' && !isBlank(*p)) p++;
+            col = UINT32_MAX;
+            continue;
+        }
+        p = res.ptr;
+        if (col < gwCount) // SF values larger than 12 mean out of range
+            row[col] = number > UINT8_MAX ? UINT8_MAX : number;
+        else if (col == gwCount) // Last column is the period
+            period = number;
+        if (col != UINT32_MAX) col++;
+    }
+    return p < end ? p + 1 : end;
+}
+
+static const char* parseSparseRow(const char* p, const char* end, uint32_t* gws, uint8_t* sfs, uint32_t& period, uint gwCount, uint& col) {
+    // Parses one line of a sparse file: period followed by "gw sf" pairs. Returns pointer to the next line
+    col = 0;
+    while (p < end && *p != '\n') {
+        if (isBlank(*p)) { p++; continue; }
+        uint number;
+        std::from_chars_result res = std::from_chars(p, end, number);
+        if (res.ec != std::errc() || (col % 2 == 1 && number >= gwCount)) { // Not a number or invalid GW
+            col = UINT32_MAX;
+            break;
+        }
+        p = res.ptr;
+        if (col == 0)
+            period = number;
+        else if (col % 2 == 1)
+            gws[col/2] = number;
+        else
+            sfs[col/2 - 1] = number > UINT8_MAX ? UINT8_MAX : number;
+        col++;
+    }
+    while (p < end && *p != '\n') p++;
+    return p < end ? p + 1 : end;
+}
+
+static bool isEmptyLine(const char* p, const char* end) {
+    while (p < end && *p != '\n') 
+        if (!isBlank(*p++)) return false;
+    return true;
+}
+
+static size_t countValues(const char* p, const char* end) {
+    size_t count = 0;
+    bool inToken = false;
+    for (; p < end && *p != '\n'; p++) {
+        const bool blank = isBlank(*p);
+        if (!blank && !inToken) count++;
+        inToken = !blank;
+    }
+    return count;
+}
+
+static inline const char* nextLine(const char* p, const char* end) {
+    const char* nl = (const char*) memchr(p, '\n', end - p);
+    return nl == nullptr ? end : nl + 1;
+}
+
+void Instance::loadTextFile(const char* filename) {
+    // The file is mapped to memory and split in chunks at line boundaries. Chunks are parsed in parallel.
+    // Dense files have "e g" in the header, sparse files have "e g pairs" and rows "period gw sf gw sf ..."
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
         std::cerr << "Failed to open input file. Check filename or file location." << std::endl;
         exit(1);
     }
+    struct stat st;
+    fstat(fd, &st);
+    if (st.st_size == 0) {
+        close(fd);
+        std::cerr << "Invalid input file. Header with ED and GW count is missing." << std::endl;
+        exit(1);
+    }
+    const size_t fileSize = st.st_size;
+    void* data = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "Failed to map input file to memory." << std::endl;
+        exit(1);
+    }
+    madvise(data, fileSize, MADV_SEQUENTIAL);
+    const char* begin = (const char*) data;
+    const char* end = begin + fileSize;
+
+    // Header: ED and GW count
+    const char* p = begin;
+    uint header[2];
+    for (uint i = 0; i < 2; i++) {
+        while (p < end && (isBlank(*p) || *p == '\n')) p++;
+        std::from_chars_result res = std::from_chars(p, end, header[i]);
+        if (res.ec != std::errc()) {
+            std::cerr << "Invalid input file. Header with ED and GW count is missing." << std::endl;
+            exit(1);
+        }
+        p = res.ptr;
+    }
+    this->edCount = header[0];
+    this->gwCount = header[1];
+    while (p < end && isBlank(*p)) p++;
+    uint64_t pairCount = 0;
+    const bool sparse = std::from_chars(p, end, pairCount).ec == std::errc(); // Third value: number of pairs
+    const char* body = nextLine(p, end);
+
+    if (sparse) {
+        this->adjOffsetsData.resize((size_t)this->edCount + 1);
+        this->adjGWData.resize(pairCount);
+        this->adjSFData.resize(pairCount);
+    } else {
+        this->sfData.resize((size_t)this->edCount*this->gwCount);
+    }
+    this->periodData.resize(this->edCount);
+
+    // Split body in chunks starting at line boundaries
+    const size_t bodySize = end - body;
+    uint threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = (uint) std::max((size_t)1, std::min((size_t)threads, bodySize / TEXT_PARSER_MIN_CHUNK));
+    std::vector<const char*> chunks(threads + 1, end);
+    chunks[0] = body;
+    for (uint t = 1; t < threads; t++)
+        chunks[t] = nextLine(std::max(chunks[t-1], body + bodySize/threads*t), end);
+
+    // First pass: count rows (and pairs if sparse) of each chunk, so each chunk knows where its data starts
+    std::vector<size_t> firstRow(threads + 1, 0);
+    std::vector<uint64_t> firstPair(threads + 1, 0);
+    std::vector<std::thread> pool;
+    for (uint t = 0; t < threads; t++)
+        pool.emplace_back([&, t]() {
+            size_t rows = 0;
+            uint64_t pairs = 0;
+            for (const char* q = chunks[t]; q < chunks[t+1]; q = nextLine(q, chunks[t+1])) {
+                if (isEmptyLine(q, chunks[t+1])) continue;
+                if (sparse)
+                    pairs += countValues(q, chunks[t+1]) / 2;
+                rows++;
+            }
+            firstRow[t+1] = rows;
+            firstPair[t+1] = pairs;
+        });
+    for (std::thread& th : pool) th.join();
+    pool.clear();
+    for (uint t = 0; t < threads; t++) {
+        firstRow[t+1] += firstRow[t];
+        firstPair[t+1] += firstPair[t];
+    }
+    uint64_t usedPairs = firstPair[threads]; // Pairs of the first edCount rows (the ones that are parsed)
+    if (sparse && firstRow[threads] > this->edCount) { // Recount the chunk with the last ED up to its row
+        uint t = 0;
+        while (firstRow[t+1] < this->edCount) t++;
+        usedPairs = firstPair[t];
+        size_t rows = firstRow[t];
+        for (const char* q = chunks[t]; q < chunks[t+1] && rows < this->edCount; q = nextLine(q, chunks[t+1])) {
+            if (isEmptyLine(q, chunks[t+1])) continue;
+            usedPairs += countValues(q, chunks[t+1]) / 2;
+            rows++;
+        }
+    }
+    if (sparse && usedPairs != pairCount) {
+        std::cerr << "Invalid input file. Found " << usedPairs << " ED-GW pairs, expected " << pairCount << "." << std::endl;
+        exit(1);
+    }
 
-    std::string line;
-    while (std::getline(file, line)) {
-        std::vector<uint> row;
-        std::stringstream ss(line);
-        int number;
-        while (ss >> number)
-            row.push_back(number);
-        this->raw.push_back(row);
-    }
-    file.close();
-
-    this->edCount = this->raw[0][0];
-    this->gwCount = this->raw[0][1];
-
-    // Check data consistency
-    /*
-    std::cout << "Checking instance data consistency..." << std::endl;
-    for(uint row = 1; row < edCount; row++){
-        for(uint col = 0; col < gwCount; col++){
-            const uint sf = this->raw[row][col];
-            if(sf < 7 || sf > 12){
-                std::cout << "Invalid file, SF values should be in range 7 to 12." << std::endl;
-                std::cout << "row " << row << ", col " << col << ", value " << sf << std::endl;
-                exit(1);
+    // Second pass: parse rows directly into the final arrays. Rows after edCount are ignored
+    std::vector<size_t> badRow(threads, SIZE_MAX); // First invalid row found by each chunk
+    std::vector<uint> badCol(threads, 0);
+    for (uint t = 0; t < threads; t++)
+        pool.emplace_back([&, t]() {
+            size_t e = firstRow[t];
+            uint64_t pair = firstPair[t];
+            for (const char* q = chunks[t]; q < chunks[t+1] && e < this->edCount;) {
+                if (isEmptyLine(q, chunks[t+1])) {
+                    q = nextLine(q, chunks[t+1]);
+                    continue;
+                }
+                uint col;
+                if (sparse) {
+                    const size_t values = countValues(q, chunks[t+1]);
+                    this->adjOffsetsData[e] = pair;
+                    q = parseSparseRow(q, chunks[t+1], &this->adjGWData[pair], &this->adjSFData[pair], this->periodData[e], this->gwCount, col);
+                    if (col != values || values % 2 == 0) { // Invalid value or incomplete pair
+                        badRow[t] = e;
+                        badCol[t] = col;
+                        break;
+                    }
+                    this->sortPairs(pair, pair + values/2);
+                    pair += values/2;
+                    e++;
+                    continue;
+                }
+                q = parseRow(q, chunks[t+1], &this->sfData[e*this->gwCount], this->periodData[e], this->gwCount, col);
+                if (col != this->gwCount + 1) {
+                    badRow[t] = e;
+                    badCol[t] = col;
+                    break;
+                }
+                e++;
             }
+        });
+    for (std::thread& th : pool) th.join();
+    munmap(data, fileSize);
+
+    for (uint t = 0; t < threads; t++)
+        if (badRow[t] != SIZE_MAX) {
+            if (badCol[t] == UINT32_MAX)
+                std::cerr << "Invalid input file. Row " << badRow[t]+1 << " contains non numeric values or invalid gateways." << std::endl;
+            else if (sparse)
+                std::cerr << "Invalid input file. Row " << badRow[t]+1 << " must contain the period followed by GW and SF pairs." << std::endl;
+            else
+                std::cerr << "Invalid input file. Row " << badRow[t]+1 << " has " << badCol[t] << " values, expected " << this->gwCount + 1 << "." << std::endl;
+            exit(1);
         }
+
+    if (firstRow[threads] < this->edCount) {
+        std::cerr << "Invalid input file. Found " << firstRow[threads] << " rows, expected " << this->edCount << "." << std::endl;
+        exit(1);
     }
-    */
+    if (sparse)
+        this->adjOffsetsData[this->edCount] = pairCount;
 
-    this->instanceFileName = new char[strlen(filename) + 1];
-    strcpy(this->instanceFileName, extractFileName(filename));
+    this->bindOwnedData(sparse);
+}
+
+void Instance::sortPairs(uint64_t first, uint64_t last) {
+    // Sorts the stored pairs of one ED by GW index
+    if (std::is_sorted(this->adjGWData.begin() + first, this->adjGWData.begin() + last))
+        return;
+    std::vector<std::pair<uint32_t, uint8_t>> pairs;
+    for (uint64_t i = first; i < last; i++)
+        pairs.push_back({this->adjGWData[i], this->adjSFData[i]});
+    std::sort(pairs.begin(), pairs.end());
+    for (uint64_t i = first; i < last; i++) {
+        this->adjGWData[i] = pairs[i - first].first;
+        this->adjSFData[i] = pairs[i - first].second;
+    }
+}
+
+bool Instance::loadBinaryFile(const char* filename) {
+    // Maps the file to memory and uses the matrix in place. Returns false if file is not a binary instance
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Failed to open input file. Check filename or file location." << std::endl;
+        exit(1);
+    }
+
+    InstanceFileHeader header;
+    if (read(fd, &header, sizeof(header)) != (ssize_t) sizeof(header) || 
+        strncmp(header.magic, INSTANCE_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        close(fd);
+        return false;
+    }
+
+    if (header.version != INSTANCE_FILE_VERSION) {
+        std::cerr << "Unsupported binary instance version " << header.version << " (expected " << INSTANCE_FILE_VERSION << ")." << std::endl;
+        exit(1);
+    }
+
+    struct stat st;
+    fstat(fd, &st);
+    const bool sparse = header.flags & INSTANCE_FILE_SPARSE;
+    const uint64_t matrixSize = (uint64_t)header.edCount*header.gwCount;
+    const uint64_t offsetsSize = ((uint64_t)header.edCount + 1)*sizeof(uint64_t);
+    if ((uint64_t)st.st_size != header.fileSize || 
+        header.sfOffset + (sparse ? offsetsSize : matrixSize) > header.fileSize ||
+        header.periodOffset + (uint64_t)header.edCount*sizeof(uint32_t) > header.fileSize ||
+        (!sparse && (header.flags & INSTANCE_FILE_TRANSPOSE) && header.transposeOffset + matrixSize > header.fileSize) ||
+        ((header.flags & INSTANCE_FILE_POSITIONS) && 
+            header.positionsOffset + ((uint64_t)header.edCount + header.gwCount)*sizeof(Position) > header.fileSize)) {
+        std::cerr << "Invalid binary instance file. File is truncated or corrupted." << std::endl;
+        exit(1);
+    }
+
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // Mapping remains valid after closing the descriptor
+    if (data == MAP_FAILED) {
+        std::cerr << "Failed to map binary instance file to memory." << std::endl;
+        exit(1);
+    }
+
+    this->mappedFile = data;
+    this->mappedSize = st.st_size;
+    this->edCount = header.edCount;
+    this->gwCount = header.gwCount;
+    this->periods = (const uint32_t*) ((const uint8_t*) data + header.periodOffset);
+    if (sparse) { // Offsets, GWs and SFs of the pairs are stored one after the other
+        this->adjOffsets = (const uint64_t*) ((const uint8_t*) data + header.sfOffset);
+        const uint64_t pairCount = this->adjOffsets[this->edCount];
+        const uint64_t pairsSpace = header.fileSize - header.sfOffset - offsetsSize; // Compared by division, products could overflow
+        bool valid = this->adjOffsets[0] == 0 && pairCount <= pairsSpace/(sizeof(uint32_t) + sizeof(uint8_t));
+        for (uint e = 0; valid && e < this->edCount; e++) // Offsets can not decrease
+            valid = this->adjOffsets[e] <= this->adjOffsets[e+1];
+        this->adjGW = (const uint32_t*) ((const uint8_t*) this->adjOffsets + offsetsSize);
+        this->adjSF = (const uint8_t*) (this->adjGW + pairCount);
+        for (uint64_t i = 0; valid && i < pairCount; i++) // Indexes are built with the GW ids, check them once
+            valid = this->adjGW[i] < this->gwCount;
+        if (!valid) {
+            std::cerr << "Invalid binary instance file. File is truncated or corrupted." << std::endl;
+            exit(1);
+        }
+    } else {
+        this->sfMatrix = (const uint8_t*) data + header.sfOffset;
+        if (header.flags & INSTANCE_FILE_TRANSPOSE)
+            this->sfMatrixT = (const uint8_t*) data + header.transposeOffset;
+    }
+
+    if (header.flags & INSTANCE_FILE_POSITIONS) { // Positions are only used for plotting, so copy them
+        const Position* pos = (const Position*) ((const uint8_t*) data + header.positionsOffset);
+        this->eds.resize(this->edCount);
+        for (uint e = 0; e < this->edCount; e++)
+            this->eds[e] = {pos[e], (int) this->periods[e]};
+        this->gws.assign(pos + this->edCount, pos + this->edCount + this->gwCount);
+    }
+
+    return true;
+}
+
+void Instance::bindOwnedData(bool sparse) {
+    if (sparse) {
+        this->adjOffsets = this->adjOffsetsData.data();
+        this->adjGW = this->adjGWData.data();
+        this->adjSF = this->adjSFData.data();
+    } else {
+        this->sfMatrix = this->sfData.data();
+    }
+    this->periods = this->periodData.data();
+}
+
+uint Instance::getSparseMinSF(uint ed, uint gw) {
+    // Binary search of the GW in the stored pairs of the ED
+    const uint32_t* first = this->adjGW + this->adjOffsets[ed];
+    const uint32_t* last = this->adjGW + this->adjOffsets[ed+1];
+    const uint32_t* it = std::lower_bound(first, last, gw);
+    return (it != last && *it == gw) ? this->adjSF[it - this->adjGW] : SF_UNREACHABLE;
+}
+
+void Instance::copyRow(uint ed, uint8_t* row) {
+    // Min SF of the ED for every GW, also for sparse instances
+    if (this->sfMatrix != nullptr) {
+        memcpy(row, this->getSFRow(ed), this->gwCount);
+        return;
+    }
+    std::fill(row, row + this->gwCount, SF_UNREACHABLE);
+    this->forEachPair(ed, [row](uint g, uint sf) { row[g] = sf; });
+}
+
+uint64_t Instance::countPairs() {
+    // Number of ED-GW pairs in range (min SF up to 12)
+    uint64_t count = 0;
+    for (uint e = 0; e < this->edCount; e++)
+        this->forEachPair(e, [&count](uint, uint sf) { if (sf <= 12) count++; });
+    return count;
+}
+
+void Instance::buildTranspose() {
+    // GW-major copy of the matrix, so per GW scans are sequential. Blocked to keep both matrices in cache
+    const uint block = SF_MATRIX_ALIGN;
+    this->sfDataT.resize((size_t)this->edCount*this->gwCount);
+    uint8_t* dst = this->sfDataT.data();
+    for(uint e0 = 0; e0 < this->edCount; e0 += block){
+        const uint e1 = std::min(e0 + block, this->edCount);
+        for(uint g0 = 0; g0 < this->gwCount; g0 += block){
+            const uint g1 = std::min(g0 + block, this->gwCount);
+            for(uint e = e0; e < e1; e++)
+                for(uint g = g0; g < g1; g++)
+                    dst[(size_t)g*this->edCount + e] = this->sfMatrix[(size_t)e*this->gwCount + g];
+        }
+    }
+    this->sfMatrixT = dst;
 }
 
 Instance::Instance(const InstanceConfig& config) {
 
-    // Header of raw data contains number of nodes
-    std::vector<uint>header = {config.edNumber, config.gwNumber};
-    this->raw.push_back(header);
+    this->mappedFile = nullptr;
+    this->mappedSize = 0;
+    this->sfMatrix = nullptr;
+    this->sfMatrixT = nullptr;
+    this->adjOffsets = nullptr;
+    this->adjGW = nullptr;
+    this->adjSF = nullptr;
+    this->originalGWCount = 0;
+    this->instanceFileName = nullptr;
+    this->edCount = config.edNumber;
+    this->gwCount = config.gwNumber;
+    if(config.sparse) // Only pairs in range are stored
+        this->adjOffsetsData.push_back(0);
+    else
+        this->sfData.reserve((size_t)config.edNumber*config.gwNumber);
+    this->periodData.reserve(config.edNumber);
     
     // Create the random generator functions
     Random* posGenerator;
@@ -121,7 +502,7 @@ Instance::Instance(const InstanceConfig& config) {
     
     // Populate instance matrix with data
     for(uint e = 0; e < this->eds.size(); e++) {
-        std::vector<uint> row; // Text line to print
+        std::vector<uint8_t> row; // Min SF of this ED for each GW
         uint availableGW = 0; // Available GW for this ED
         uint tries = 0;
         while(availableGW == 0 && tries < MAX_TRIES){ // Try many times until feasible system
@@ -150,29 +531,166 @@ Instance::Instance(const InstanceConfig& config) {
                         << "Period = " << this->eds[e].period << std::endl;
             exit(1);
         }
-        row.push_back(this->eds[e].period); // Add period as last element
-        this->raw.push_back(row); // Add row to data
+        if(config.sparse){
+            for(uint g = 0; g < row.size(); g++)
+                if(row[g] <= 12){
+                    this->adjGWData.push_back(g);
+                    this->adjSFData.push_back(row[g]);
+                }
+            this->adjOffsetsData.push_back(this->adjGWData.size());
+        }else
+            this->sfData.insert(this->sfData.end(), row.begin(), row.end()); // Add row to data
+        this->periodData.push_back(this->eds[e].period); // Period is the last column of raw data
     } // Raw data is ready to export (or use)
-    // Set attributes (in case of using config to generate an instance to solve)
-    this->edCount = config.edNumber;
-    this->gwCount = config.gwNumber;
+    this->bindOwnedData(config.sparse);
+    if(!config.sparse)
+        this->buildTranspose();
+    this->buildTables();
+    this->buildIndexes();
+    this->presolve();
+}
+
+Instance::Instance(Instance* source, const std::vector<uint>& gwSubset) {
+    // Same EDs with only the given GWs. Storage backend (dense or sparse) is kept
+    this->mappedFile = nullptr;
+    this->mappedSize = 0;
+    this->sfMatrix = nullptr;
+    this->sfMatrixT = nullptr;
+    this->adjOffsets = nullptr;
+    this->adjGW = nullptr;
+    this->adjSF = nullptr;
+    this->outputFormat = INSTANCE_OUT_FORMAT::NONE;
+    this->edCount = source->edCount;
+    this->gwCount = gwSubset.size();
+    this->originalGWCount = source->getOriginalGWCount();
+    this->originalGW.resize(this->gwCount);
+    for(uint g = 0; g < this->gwCount; g++)
+        this->originalGW[g] = source->getOriginalGW(gwSubset[g]);
+
+    const bool sparse = source->isSparse();
+    std::vector<uint> newIndex(source->gwCount, UINT32_MAX); // Index of each source GW in this instance
+    for(uint g = 0; g < this->gwCount; g++)
+        newIndex[gwSubset[g]] = g;
+    if(sparse)
+        this->adjOffsetsData.push_back(0);
+    else
+        this->sfData.resize((size_t)this->edCount*this->gwCount);
+    this->periodData.resize(this->edCount);
+    this->edWeights = source->edWeights; // Aggregated EDs are kept
+    this->edClass = source->edClass;
+    for(uint e = 0; e < this->edCount; e++){
+        this->periodData[e] = source->getPeriod(e);
+        if(sparse){
+            const uint64_t first = this->adjGWData.size();
+            source->forEachPair(e, [&](uint g, uint sf) {
+                if(newIndex[g] != UINT32_MAX){
+                    this->adjGWData.push_back(newIndex[g]);
+                    this->adjSFData.push_back(sf);
+                }
+            });
+            this->adjOffsetsData.push_back(this->adjGWData.size());
+            this->sortPairs(first, this->adjGWData.size());
+        }else{
+            const uint8_t* row = source->getSFRow(e);
+            uint8_t* newRow = &this->sfData[(size_t)e*this->gwCount];
+            for(uint g = 0; g < this->gwCount; g++)
+                newRow[g] = row[gwSubset[g]];
+        }
+    }
+    if(source->eds.size() == source->edCount && source->gws.size() == source->gwCount){ // Positions for plots
+        this->eds = source->eds;
+        for(uint g : gwSubset)
+            this->gws.push_back(source->gws[g]);
+    }
+    this->bindOwnedData(sparse);
+    if(!sparse)
+        this->buildTranspose();
+    this->buildTables();
+    this->buildIndexes();
+    this->presolve();
+
+    const char* name = source->getInstanceFileName() != nullptr ? source->getInstanceFileName() : "";
+    this->instanceFileName = new char[strlen(name) + 1];
+    strcpy(this->instanceFileName, name);
+}
+
+Instance::Instance(Instance* source, const std::vector<std::vector<uint>>& edGroups) {
+    // One ED for each group, with the row and period of its first member. GWs and storage backend are kept
+    this->mappedFile = nullptr;
+    this->mappedSize = 0;
+    this->sfMatrix = nullptr;
+    this->sfMatrixT = nullptr;
+    this->adjOffsets = nullptr;
+    this->adjGW = nullptr;
+    this->adjSF = nullptr;
+    this->outputFormat = INSTANCE_OUT_FORMAT::NONE;
+    this->edCount = edGroups.size();
+    this->gwCount = source->gwCount;
+    this->originalGWCount = source->originalGWCount;
+    this->originalGW = source->originalGW;
+
+    const bool sparse = source->isSparse();
+    std::vector<uint> groupOf(source->edCount); // Index of the group of each source ED
+    if(sparse)
+        this->adjOffsetsData.push_back(0);
+    else
+        this->sfData.resize((size_t)this->edCount*this->gwCount);
+    this->periodData.resize(this->edCount);
+    this->edWeights.resize(this->edCount, 0);
+    for(uint c = 0; c < this->edCount; c++){
+        const uint e = edGroups[c][0];
+        for(uint m : edGroups[c]){
+            groupOf[m] = c;
+            this->edWeights[c] += source->getWeight(m);
+        }
+        this->periodData[c] = source->getPeriod(e);
+        if(sparse){
+            source->forEachPair(e, [&](uint g, uint sf) {
+                this->adjGWData.push_back(g);
+                this->adjSFData.push_back(sf);
+            });
+            this->adjOffsetsData.push_back(this->adjGWData.size());
+        }else{
+            memcpy(&this->sfData[(size_t)c*this->gwCount], source->getSFRow(e), this->gwCount);
+        }
+        if(source->eds.size() == source->edCount) // Positions for plots
+            this->eds.push_back(source->eds[e]);
+    }
+    this->gws = source->gws;
+    this->edClass.resize(source->getOriginalEDCount());
+    for(uint o = 0; o < this->edClass.size(); o++)
+        this->edClass[o] = groupOf[source->getEDClass(o)];
+
+    this->bindOwnedData(sparse);
+    if(!sparse)
+        this->buildTranspose();
+    this->buildTables();
+    this->buildIndexes();
+    this->presolve();
+
+    const char* name = source->getInstanceFileName() != nullptr ? source->getInstanceFileName() : "";
+    this->instanceFileName = new char[strlen(name) + 1];
+    strcpy(this->instanceFileName, name);
 }
 
 Instance::~Instance() {
     delete[] this->instanceFileName;
+    if(this->mappedFile != nullptr)
+        munmap(this->mappedFile, this->mappedSize);
 }
 
 void Instance::printRawData() {
-    for (const auto& row : this->raw) {
-        for (int num : row) 
-            std::cout << num << " ";
-        std::cout << std::endl;
+    std::cout << this->edCount << " " << this->gwCount << " " << std::endl;
+    for (uint e = 0; e < this->edCount; e++) {
+        for (uint g = 0; g < this->gwCount; g++) 
+            std::cout << this->getMinSF(e, g) << " ";
+        std::cout << this->getPeriod(e) << " " << std::endl;
     }
 }
 
-void Instance::exportRawData(const char* filename) {
+void Instance::exportRawData(const char* filename, bool sparse) {
 
-    std::string filenameWithExtension = std::string(filename) + ".dat";
+    std::string filenameWithExtension = filename != nullptr ? std::string(filename) + ".dat" : "";
     std::ostream& output = (filename != nullptr) ? *new std::ofstream(filenameWithExtension) : std::cout;
 
 
@@ -181,16 +699,127 @@ void Instance::exportRawData(const char* filename) {
         exit(1);
     }
 
-    for (const auto& row : this->raw) {
-        for (int num : row)
-            output << num << " ";
-        output << '\n';
+    if (sparse) { // Only pairs in range: "period gw sf gw sf ..."
+        output << this->edCount << " " << this->gwCount << " " << this->countPairs() << " " << '\n';
+        for (uint e = 0; e < this->edCount; e++) {
+            output << this->getPeriod(e) << " ";
+            this->forEachPair(e, [&output](uint g, uint sf) { 
+                if (sf <= 12) output << g << " " << sf << " ";
+            });
+            output << '\n';
+        }
+    } else {
+        std::vector<uint8_t> row(this->gwCount);
+        output << this->edCount << " " << this->gwCount << " " << '\n';
+        for (uint e = 0; e < this->edCount; e++) {
+            this->copyRow(e, row.data());
+            for (uint g = 0; g < this->gwCount; g++)
+                output << (uint) row[g] << " ";
+            output << this->getPeriod(e) << " " << '\n';
+        }
     }
 
-    if (filename != nullptr) 
+    if (filename != nullptr) {
         dynamic_cast<std::ofstream&>(output).close();
+        delete &output;
+        std::cout << "Plain text file generated: " << filenameWithExtension << std::endl;
+    }
+}
+
+void Instance::exportBinaryData(const char* filename, bool sparse) {
+    // Sections are aligned so the matrix can be used in place after mapping the file
+    auto align = [](uint64_t offset) { return (offset + INSTANCE_FILE_ALIGN - 1) / INSTANCE_FILE_ALIGN * INSTANCE_FILE_ALIGN; };
+    const bool hasPositions = this->eds.size() == this->edCount && this->gws.size() == this->gwCount;
+    const uint64_t matrixSize = (uint64_t)this->edCount*this->gwCount;
+    const uint64_t pairCount = sparse ? this->countPairs() : 0;
+    const uint64_t sfSize = sparse ? ((uint64_t)this->edCount + 1)*sizeof(uint64_t) + pairCount*(sizeof(uint32_t) + sizeof(uint8_t)) : matrixSize;
+
+    InstanceFileHeader header;
+    memset(&header, 0, sizeof(header));
+    strncpy(header.magic, INSTANCE_FILE_MAGIC, sizeof(header.magic));
+    header.version = INSTANCE_FILE_VERSION;
+    header.flags = (sparse ? INSTANCE_FILE_SPARSE : INSTANCE_FILE_TRANSPOSE) | (hasPositions ? INSTANCE_FILE_POSITIONS : 0);
+    header.edCount = this->edCount;
+    header.gwCount = this->gwCount;
+    header.sfOffset = sizeof(header);
+    header.periodOffset = align(header.sfOffset + sfSize);
+    uint64_t end = header.periodOffset + (uint64_t)this->edCount*sizeof(uint32_t);
+    if (!sparse) {
+        header.transposeOffset = align(end);
+        end = header.transposeOffset + matrixSize;
+    }
+    if (hasPositions) {
+        header.positionsOffset = align(end);
+        end = header.positionsOffset + (uint64_t)(this->edCount + this->gwCount)*sizeof(Position);
+    }
+    header.fileSize = end;
 
-    std::cout << "Plain text file generated: " << (std::string(filename) + ".dat") << std::endl;
+    std::string filenameWithExtension = std::string(filename) + ".bin";
+    std::ofstream output(filenameWithExtension, std::ios::binary);
+    if (!output) { 
+        std::cerr << "Failed to open output stream." << std::endl;
+        exit(1);
+    }
+
+    auto pad = [&output](uint64_t offset) {
+        const char zeros[INSTANCE_FILE_ALIGN] = {0};
+        const uint64_t pos = output.tellp();
+        if (offset > pos) output.write(zeros, offset - pos);
+    };
+
+    output.write((const char*) &header, sizeof(header));
+    if (sparse) { // Only pairs in range
+        std::vector<uint32_t> gws;
+        std::vector<uint8_t> sfs;
+        gws.reserve(pairCount);
+        sfs.reserve(pairCount);
+        uint64_t offset = 0;
+        output.write((const char*) &offset, sizeof(offset));
+        for (uint e = 0; e < this->edCount; e++) {
+            this->forEachPair(e, [&gws, &sfs](uint g, uint sf) {
+                if (sf <= 12) {
+                    gws.push_back(g);
+                    sfs.push_back(sf);
+                }
+            });
+            offset = gws.size();
+            output.write((const char*) &offset, sizeof(offset));
+        }
+        output.write((const char*) gws.data(), gws.size()*sizeof(uint32_t));
+        output.write((const char*) sfs.data(), sfs.size());
+    } else if (this->sfMatrix != nullptr) {
+        output.write((const char*) this->sfMatrix, matrixSize);
+    } else { // Expand sparse instance
+        std::vector<uint8_t> row(this->gwCount);
+        for (uint e = 0; e < this->edCount; e++) {
+            this->copyRow(e, row.data());
+            output.write((const char*) row.data(), this->gwCount);
+        }
+    }
+    pad(header.periodOffset);
+    output.write((const char*) this->periods, (size_t)this->edCount*sizeof(uint32_t));
+    if (!sparse) {
+        pad(header.transposeOffset);
+        if (this->sfMatrixT != nullptr)
+            output.write((const char*) this->sfMatrixT, matrixSize);
+        else {
+            std::vector<uint8_t> column(this->edCount);
+            for (uint g = 0; g < this->gwCount; g++) {
+                for (uint e = 0; e < this->edCount; e++)
+                    column[e] = this->getMinSF(e, g);
+                output.write((const char*) column.data(), this->edCount);
+            }
+        }
+    }
+    if (hasPositions) {
+        pad(header.positionsOffset);
+        for (const EndDevice& ed : this->eds)
+            output.write((const char*) &ed.pos, sizeof(Position));
+        output.write((const char*) this->gws.data(), this->gwCount*sizeof(Position));
+    }
+    output.close();
+
+    std::cout << "Binary file generated: " << filenameWithExtension << std::endl;
 }
 
 void Instance::generateHtmlPlot(const char* filename) {
@@ -366,21 +995,29 @@ void Instance::generateSvgPlot(const char* filename) {
 
 void Instance::copySFDataTo(std::vector<std::vector<uint>>& destination) {
     // Make a copy of the raw data, only sf values
-    copyMatrix(this->raw, destination, 1, this->edCount, 0, this->gwCount-1);
-}
-
-uint Instance::getMinSF(uint ed, uint gw) {
-    return this->raw[ed+1][gw];
-}
-
-uint Instance::getMaxSF(uint ed) {
-    return this->_getMaxSF(this->getPeriod(ed));
+    std::vector<uint8_t> row(this->gwCount);
+    destination.resize(this->edCount);
+    for (uint e = 0; e < this->edCount; e++){
+        this->copyRow(e, row.data());
+        destination[e].assign(row.begin(), row.end());
+    }
 }
 
-UtilizationFactor Instance::getUF(uint ed, uint sf) {
-    double pw = (double) this->sf2e(sf);
-    double ufValue = pw / ((double)this->getPeriod(ed) - pw);
-    return UtilizationFactor(sf, ufValue);
+void Instance::buildTables() {
+    // Max SF and UF values only depend on the period, so they are computed once
+    this->maxSFTable.resize(this->edCount);
+    this->ufTable.resize((size_t)SF_NUM*this->edCount);
+    this->ufFixedTable.resize((size_t)SF_NUM*this->edCount);
+    for(uint e = 0; e < this->edCount; e++){
+        const double period = (double) this->getPeriod(e);
+        const double weight = (double) this->getWeight(e); // Aggregated EDs use the UF of all the class
+        this->maxSFTable[e] = this->_getMaxSF(this->getPeriod(e));
+        for(uint s = 7; s <= 12; s++){
+            const double pw = (double) this->sf2e(s);
+            this->ufTable[(size_t)(s-7)*this->edCount + e] = weight * pw / (period - pw);
+            this->ufFixedTable[(size_t)(s-7)*this->edCount + e] = toFixedUF(weight * pw / (period - pw));
+        }
+    }
 }
 
 uint Instance::_getMaxSF(uint period) {
@@ -437,80 +1074,427 @@ uint Instance::_getMinSFScaled(double distance) {
         return 100;
 }
 
-uint Instance::getPeriod(uint ed) {
-    return this->raw[ed+1][this->gwCount]; // Last column of raw data
+void Instance::buildIndexes() {
+    // Single pass over the stored pairs to build the CSR indexes. Pairs with min SF greater than max SF are not reachable
+    std::vector<size_t> bucketCount((size_t)this->gwCount*SF_NUM, 0);
+    this->edGWOffsets.assign(this->edCount + 1, 0);
+    for(uint e = 0; e < this->edCount; e++){
+        const uint maxSF = this->getMaxSF(e);
+        uint count = 0;
+        this->forEachPair(e, [&](uint g, uint sf) {
+            if(sf >= 7 && sf <= maxSF){
+                bucketCount[(size_t)g*SF_NUM + sf - 7]++;
+                count++;
+            }
+        });
+        this->edGWOffsets[e+1] = this->edGWOffsets[e] + count;
+    }
+
+    this->gwEDOffsets.assign(bucketCount.size() + 1, 0);
+    for(size_t b = 0; b < bucketCount.size(); b++)
+        this->gwEDOffsets[b+1] = this->gwEDOffsets[b] + bucketCount[b];
+
+    // Second pass: fill lists. GWs of each ED are bucket sorted by SF, EDs of each bucket are sorted by index
+    this->edGWIndex.resize(this->edGWOffsets[this->edCount]);
+    this->gwEDIndex.resize(this->gwEDOffsets[bucketCount.size()]);
+    std::vector<size_t> bucketPos; // Next position of each (GW, SF) bucket, only if sparse
+    if(this->isSparse())
+        bucketPos.assign(this->gwEDOffsets.begin(), this->gwEDOffsets.end() - 1);
+    for(uint e = 0; e < this->edCount; e++){
+        const uint maxSF = this->getMaxSF(e);
+        size_t sfPos[SF_NUM] = {0}; // Position of the next GW of each SF in the list of this ED
+        this->forEachPair(e, [&](uint, uint sf) {
+            if(sf >= 7 && sf <= maxSF)
+                sfPos[sf - 7]++;
+        });
+        size_t pos = this->edGWOffsets[e];
+        for(uint k = 0; k < SF_NUM; k++){
+            const size_t count = sfPos[k];
+            sfPos[k] = pos;
+            pos += count;
+        }
+        this->forEachPair(e, [&](uint g, uint sf) {
+            if(sf >= 7 && sf <= maxSF){
+                this->edGWIndex[sfPos[sf - 7]++] = g;
+                if(!bucketPos.empty()) // EDs are visited in order, so buckets remain sorted
+                    this->gwEDIndex[bucketPos[(size_t)g*SF_NUM + sf - 7]++] = e;
+            }
+        });
+    }
+    if(this->isSparse()) return;
+    for(uint g = 0; g < this->gwCount; g++){ // Sequential scan of each GW column
+        const uint8_t* column = this->getSFColumn(g);
+        size_t sfPos[SF_NUM];
+        for(uint k = 0; k < SF_NUM; k++)
+            sfPos[k] = this->gwEDOffsets[(size_t)g*SF_NUM + k];
+        for(uint e = 0; e < this->edCount; e++)
+            if(column[e] >= 7 && column[e] <= this->maxSFTable[e])
+                this->gwEDIndex[sfPos[column[e] - 7]++] = e;
+    }
 }
 
-std::vector<uint> Instance::getGWList(uint ed) {
-    // Returns all GW that can be connected to ED
-    std::vector<uint> gwList;
-    const uint maxSF = getMaxSF(ed);
-    for(uint gw = 0; gw < this->gwCount; gw++){
-        // If SF >= maxSF -> GW is out of range for this ed
-        const uint minSF = this->getMinSF(ed, gw);
-        if(minSF <= maxSF) 
-            gwList.push_back(gw);
+void Instance::presolve() {
+    // Essential nodes, forced SFs and infeasibility conditions. Only the reachability index is used
+    PresolveInfo& info = this->presolveInfo;
+    info.gwIsEssential.assign(this->gwCount, 0);
+    info.forcedSF.assign(this->edCount, 0);
+    std::vector<UtilizationFactor> essentialUF(this->gwCount); // UF of the essential EDs of each GW
+    for(uint e = 0; e < this->edCount; e++){
+        const IndexSpan gws = this->getGWSpan(e);
+        if(gws.empty()){
+            info.uncoveredEDs.push_back(e);
+            continue;
+        }
+        const uint maxSF = this->getMaxSF(e);
+        if(this->getMinSF(e, gws[0]) == maxSF) // GWs are sorted by min SF, so all of them need max SF
+            info.forcedSF[e] = maxSF;
+        if(gws.size() == 1){
+            const uint g = gws[0];
+            info.essentialEDs.push_back(e);
+            info.gwIsEssential[g] = 1;
+            essentialUF[g] += this->getUF(e, this->getMinSF(e, g));
+        }
+    }
+    for(uint g = 0; g < this->gwCount; g++)
+        if(info.gwIsEssential[g]){
+            info.essentialGWs.push_back(g);
+            if(essentialUF[g].isFull())
+                info.overloadedGWs.push_back(g);
+        }
+}
+
+static inline uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+    // FNV-1a over 64 bit words (tail bytes one at a time). The shift mixes high bits into the low ones
+    const uint8_t* bytes = (const uint8_t*) data;
+    size_t i = 0;
+    for(; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)){
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ULL;
+        hash ^= hash >> 32;
+    }
+    for(; i < size; i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    return hash;
+}
+
+uint64_t Instance::getContentHash() {
+    uint64_t hash = 14695981039346656037ULL;
+    const uint8_t sparse = this->isSparse();
+    hash = hashBytes(hash, &this->edCount, sizeof(this->edCount));
+    hash = hashBytes(hash, &this->gwCount, sizeof(this->gwCount));
+    hash = hashBytes(hash, &sparse, sizeof(sparse));
+    hash = hashBytes(hash, this->periods, (size_t)this->edCount*sizeof(uint32_t));
+    if(sparse){
+        const uint64_t pairCount = this->adjOffsets[this->edCount];
+        hash = hashBytes(hash, this->adjOffsets, ((size_t)this->edCount + 1)*sizeof(uint64_t));
+        hash = hashBytes(hash, this->adjGW, pairCount*sizeof(uint32_t));
+        hash = hashBytes(hash, this->adjSF, pairCount*sizeof(uint8_t));
+    }else{
+        hash = hashBytes(hash, this->sfMatrix, (size_t)this->edCount*this->gwCount);
+    }
+    if(!this->edWeights.empty())
+        hash = hashBytes(hash, this->edWeights.data(), this->edWeights.size()*sizeof(uint));
+    return hash;
+}
+
+template <typename T> static void writeArray(std::ofstream& output, const std::vector<T>& values) {
+    const uint64_t size = values.size();
+    output.write((const char*) &size, sizeof(size));
+    output.write((const char*) values.data(), size*sizeof(T));
+}
+
+template <typename T> static bool readArray(std::ifstream& input, std::vector<T>& values, uint64_t maxBytes) {
+    uint64_t size;
+    if(!input.read((char*) &size, sizeof(size)) || size > maxBytes/sizeof(T))
+        return false;
+    values.resize(size);
+    return (bool) input.read((char*) values.data(), size*sizeof(T));
+}
+
+static_assert(sizeof(size_t) == sizeof(uint64_t), "Index offsets are stored as 64 bit values");
+
+void Instance::exportIndexCache(const char* filename) {
+    // Written to a temporary file and then renamed, so other processes never read a partial cache
+    const std::string cacheFileName = std::string(filename) + INDEX_CACHE_EXTENSION;
+    const std::string tmpFileName = cacheFileName + ".tmp";
+    std::ofstream output(tmpFileName, std::ios::binary);
+    if (!output) { 
+        std::cerr << "Failed to open output stream." << std::endl;
+        exit(1);
+    }
+
+    IndexCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    strncpy(header.magic, INDEX_CACHE_MAGIC, sizeof(header.magic));
+    header.version = INDEX_CACHE_VERSION;
+    header.edCount = this->edCount;
+    header.gwCount = this->gwCount;
+    header.contentHash = this->getContentHash();
+    output.write((const char*) &header, sizeof(header));
+
+    const PresolveInfo& info = this->presolveInfo;
+    writeArray(output, this->edGWOffsets);
+    writeArray(output, this->edGWIndex);
+    writeArray(output, this->gwEDOffsets);
+    writeArray(output, this->gwEDIndex);
+    writeArray(output, info.essentialEDs);
+    writeArray(output, info.essentialGWs);
+    writeArray(output, info.gwIsEssential);
+    writeArray(output, info.forcedSF);
+    writeArray(output, info.uncoveredEDs);
+    writeArray(output, info.overloadedGWs);
+
+    header.fileSize = output.tellp();
+    output.seekp(0);
+    output.write((const char*) &header, sizeof(header));
+    output.close();
+    if (!output || rename(tmpFileName.c_str(), cacheFileName.c_str()) != 0) {
+        std::cerr << "Failed to write index cache file " << cacheFileName << std::endl;
+        exit(1);
+    }
+}
+
+bool Instance::loadIndexCache(const char* filename) {
+    // Returns false if there is no cache for this instance, or it was built from different data
+    std::ifstream input(filename, std::ios::binary);
+    if (!input) return false;
+    struct stat st;
+    IndexCacheHeader header;
+    if (stat(filename, &st) != 0 ||
+        !input.read((char*) &header, sizeof(header)) ||
+        strncmp(header.magic, INDEX_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != INDEX_CACHE_VERSION ||
+        header.edCount != this->edCount ||
+        header.gwCount != this->gwCount ||
+        header.fileSize != (uint64_t)st.st_size ||
+        header.contentHash != this->getContentHash())
+        return false;
+
+    PresolveInfo& info = this->presolveInfo;
+    const uint64_t maxBytes = header.fileSize;
+    const bool valid = 
+        readArray(input, this->edGWOffsets, maxBytes) &&
+        readArray(input, this->edGWIndex, maxBytes) &&
+        readArray(input, this->gwEDOffsets, maxBytes) &&
+        readArray(input, this->gwEDIndex, maxBytes) &&
+        readArray(input, info.essentialEDs, maxBytes) &&
+        readArray(input, info.essentialGWs, maxBytes) &&
+        readArray(input, info.gwIsEssential, maxBytes) &&
+        readArray(input, info.forcedSF, maxBytes) &&
+        readArray(input, info.uncoveredEDs, maxBytes) &&
+        readArray(input, info.overloadedGWs, maxBytes) &&
+        this->edGWOffsets.size() == (size_t)this->edCount + 1 &&
+        this->gwEDOffsets.size() == (size_t)this->gwCount*SF_NUM + 1 &&
+        this->edGWOffsets.back() == this->edGWIndex.size() &&
+        this->gwEDOffsets.back() == this->gwEDIndex.size() &&
+        info.gwIsEssential.size() == this->gwCount &&
+        info.forcedSF.size() == this->edCount;
+    if (!valid) { // Corrupted file, indexes have to be built
+        this->presolveInfo = PresolveInfo();
+        return false;
     }
-    if(gwList.size() == 0) { // No available gws for this ed
+    return true;
+}
+
+std::vector<uint> Instance::getNonDominatedGWs() {
+    // GW a is dominated by GW b if b reaches every ED of a with the same or lower min SF and can serve all of them (UF < 1)
+    // together with the EDs of the GWs it already dominates and the EDs that only b reaches.
+    // From a group of duplicated GWs, only the first one is kept
+    std::vector<uint> result;
+    std::vector<UtilizationFactor> absorbed(this->gwCount); // Load that each GW has to take in the reduced instance
+    std::vector<uint> chargedTo(this->edCount, this->gwCount); // GW whose absorbed load includes the ED
+    std::vector<bool> dropped(this->gwCount, false);
+    for(uint e = 0; e < this->edCount; e++)
+        if(this->getReachableGWCount(e) == 1){
+            const uint g = this->getGWSpan(e)[0];
+            absorbed[g] += this->getUF(e, this->getMinSF(e, g));
+            chargedTo[e] = g;
+        }
+    for(uint a = 0; a < this->gwCount; a++){
+        const IndexSpan edsOfA = this->getReachableEDSpan(a, 12);
+        if(edsOfA.empty()) continue; // Not useful
+        uint pivot = edsOfA[0]; // Dominant GWs must reach the ED with fewer options
+        for(uint e : edsOfA)
+            if(this->getReachableGWCount(e) < this->getReachableGWCount(pivot))
+                pivot = e;
+        bool dominated = false;
+        for(uint b : this->getGWSpan(pivot)){
+            if(b == a || dropped[b] || this->getReachableEDCount(b) < edsOfA.size()) continue;
+            bool covers = true;
+            bool equal = this->getReachableEDCount(b) == edsOfA.size();
+            UtilizationFactor load = absorbed[b]; // Otherwise a may be needed for capacity
+            for(uint e : edsOfA){
+                const uint sfA = this->getMinSF(e, a);
+                const uint sfB = this->getMinSF(e, b);
+                if(sfB < 7 || sfB > sfA){
+                    covers = false;
+                    break;
+                }
+                if(sfB != sfA) equal = false;
+                if(chargedTo[e] != b) load += this->getUF(e, sfB);
+                if(load.isFull()){
+                    covers = false;
+                    break;
+                }
+            }
+            if(covers && (!equal || b < a)){
+                dominated = true;
+                dropped[a] = true;
+                absorbed[b] = load;
+                for(uint e : edsOfA)
+                    chargedTo[e] = b;
+                break;
+            }
+        }
+        if(!dominated)
+            result.push_back(a);
+    }
+    if(result.empty()) // Unfeasible instance, keep at least one GW
+        result.push_back(0);
+    return result;
+}
+
+Instance* Instance::reduceGateways(bool verbose) {
+    // Returns a new instance without dominated GWs. Results of solvers have to be mapped with getOriginalGW
+    const std::vector<uint> gws = this->getNonDominatedGWs();
+    if(verbose)
+        std::cout << "GW reduction: " << gws.size() << " of " << this->gwCount << " GWs kept." << std::endl;
+    return new Instance(this, gws);
+}
+
+std::vector<std::vector<uint>> Instance::getIdenticalEDGroups() {
+    // EDs with the same period and the same min SF for every reachable GW are interchangeable.
+    // Groups are split so that the UF of a group at its max SF stays below 1, otherwise it could not be allocated
+    std::unordered_map<std::string, uint> groupOfKey;
+    std::vector<std::vector<uint>> groups;
+    std::string key;
+    for(uint e = 0; e < this->edCount; e++){
+        const uint maxSF = this->getMaxSF(e);
+        key.assign((const char*) &this->periods[e], sizeof(uint32_t));
+        this->forEachPair(e, [&](uint g, uint sf) {
+            if(sf >= 7 && sf <= maxSF){
+                key.append((const char*) &g, sizeof(uint));
+                key.push_back((char) sf);
+            }
+        });
+        auto it = groupOfKey.find(key);
+        if(it == groupOfKey.end()){
+            groupOfKey.emplace(key, groups.size());
+            groups.push_back({e});
+        }else{
+            groups[it->second].push_back(e);
+        }
+    }
+
+    std::vector<std::vector<uint>> result;
+    for(const std::vector<uint>& group : groups){
+        const uint e = group[0];
+        const uint maxSF = this->getMaxSF(e);
+        const double unitUF = maxSF >= 7 && maxSF <= 12 ? this->getUFValue(e, maxSF) / this->getWeight(e) : 1.0; // UF of a single original ED
+        uint maxWeight = (uint) (1.0 / unitUF); // Max number of original EDs in a class
+        if(maxWeight * unitUF >= 1.0) maxWeight--;
+        if(group.size() == 1 || maxWeight <= 1){
+            for(uint m : group) result.push_back({m});
+            continue;
+        }
+        uint weight = 0;
+        for(uint m : group) weight += this->getWeight(m);
+        const uint parts = (weight + maxWeight - 1) / maxWeight;
+        const uint target = (weight + parts - 1) / parts; // Similar weight for all parts
+        result.push_back({});
+        uint partWeight = 0;
+        for(uint m : group){
+            if(partWeight > 0 && partWeight + this->getWeight(m) > target){
+                result.push_back({});
+                partWeight = 0;
+            }
+            result.back().push_back(m);
+            partWeight += this->getWeight(m);
+        }
+    }
+    return result;
+}
+
+Instance* Instance::aggregateEDs(bool verbose) {
+    // Returns a new instance with one weighted ED for each class of identical EDs. Results of solvers have to be mapped with expandSolution
+    const std::vector<std::vector<uint>> groups = this->getIdenticalEDGroups();
+    if(verbose)
+        std::cout << "ED aggregation: " << groups.size() << " classes for " << this->getOriginalEDCount() << " EDs." << std::endl;
+    return new Instance(this, groups);
+}
+
+void Instance::expandSolution(const uint* gw, const uint* sf, uint* originalGW, uint* originalSF) {
+    // All EDs of a class share the GW and SF of the class (GW indexes are not changed by aggregation)
+    for(uint e = 0; e < this->getOriginalEDCount(); e++){
+        const uint c = this->getEDClass(e);
+        originalGW[e] = gw[c];
+        originalSF[e] = sf[c];
+    }
+}
+
+void Instance::printPresolveReport() {
+    const PresolveInfo& info = this->presolveInfo;
+    uint forced = 0;
+    for(uint e = 0; e < this->edCount; e++)
+        if(info.forcedSF[e] != 0) forced++;
+    std::cout << "Presolve:" << std::endl;
+    std::cout << "  Essential EDs: " << info.essentialEDs.size() << std::endl;
+    std::cout << "  Essential GWs: " << info.essentialGWs.size() << " (of " << this->gwCount << ")" << std::endl;
+    std::cout << "  EDs with forced SF: " << forced << std::endl;
+    if(!info.uncoveredEDs.empty()){
+        std::cout << "  EDs without reachable GW: " << info.uncoveredEDs.size() << std::endl << "   ";
+        for(uint e : info.uncoveredEDs)
+            std::cout << " " << e << " (period " << this->getPeriod(e) << ")";
+        std::cout << std::endl;
+    }
+    if(!info.overloadedGWs.empty()){
+        std::cout << "  Essential GWs with UF >= 1 from essential EDs only: " << info.overloadedGWs.size() << std::endl << "   ";
+        for(uint g : info.overloadedGWs)
+            std::cout << " " << g;
+        std::cout << std::endl;
+    }
+}
+
+std::vector<uint> Instance::getGWList(uint ed) {
+    // Returns all GW that can be connected to ED (sorted by GW index)
+    const IndexSpan span = this->getGWSpan(ed);
+    if(span.empty()) { // No available gws for this ed
         std::cerr << "Error: Unfeasible system. An End-Device cannot be connected to any Gateway given its period." << std::endl
                   << "ED = " << ed << std::endl;
         exit(1);
     }
+    std::vector<uint> gwList(span.begin(), span.end());
+    std::sort(gwList.begin(), gwList.end());
     return gwList;
 }
 
 std::vector<uint> Instance::getSortedGWList(uint ed) {
     // Returns all GW that can be connected to ED sorted by SF (distance)
-    std::vector<uint> gwList;
-    const uint maxSF = getMaxSF(ed);
-    uint frontSF = maxSF;
-    //uint backSF = maxSF;
-    for(uint gw = 0; gw < this->gwCount; gw++){
-        // If SF >= maxSF -> GW is out of range for this ed
-        const uint minSF = this->getMinSF(ed, gw);
-        if(minSF <= maxSF){ 
-            if(minSF < frontSF){
-                gwList.insert(gwList.begin(), gw);
-                frontSF = minSF; /// TODO: bug
-            }else{
-                gwList.push_back(gw);
-                //backSF = minSF;
-            }
-        }
-    }
-    if(gwList.size() == 0) { // No available gws for this ed
+    const IndexSpan span = this->getGWSpan(ed);
+    if(span.empty()) { // No available gws for this ed
         std::cerr << "Error: Unfeasible system. An End-Device cannot be connected to any Gateway given its period." << std::endl
                   << "ED = " << ed << std::endl;
         exit(1);
     }
-    return gwList;
+    return std::vector<uint>(span.begin(), span.end());
 }
 
 std::vector<uint> Instance::getSortedGWListByAvailableEd(uint ed) {
     // Returns all GW that can be connected to ED sorted by available ED
-    std::vector<uint> gwList;
-    std::vector<uint> edListSizes;
-    const uint maxSF = getMaxSF(ed);
-    for(uint gw = 0; gw < this->gwCount; gw++){
-        // If SF >= maxSF -> GW is out of range for this ed
-        const uint minSF = this->getMinSF(ed, gw);
-        if(minSF <= maxSF){ 
-            const uint sz = this->getAllEDList(gw, maxSF).size();
-            gwList.push_back(gw); 
-            edListSizes.push_back(sz);
-        }
-    }
-    if(gwList.size() == 0) { // No available gws for this ed
+    const IndexSpan span = this->getGWSpan(ed);
+    if(span.empty()) { // No available gws for this ed
         std::cerr << "Error: Unfeasible system. An End-Device cannot be connected to any Gateway given its period." << std::endl
                   << "ED = " << ed << std::endl;
         exit(1);
     }
-
-    std::sort(
+    const uint maxSF = getMaxSF(ed);
+    std::vector<uint> gwList(span.begin(), span.end());
+    std::stable_sort(
         gwList.begin(), 
         gwList.end(), 
-        [&edListSizes](const uint &a, const uint &b) {
-            return edListSizes[a] < edListSizes[b];
+        [this, maxSF](const uint &a, const uint &b) {
+            return this->getReachableEDSpan(a, maxSF-1).size() < this->getReachableEDSpan(b, maxSF-1).size();
         }
     );
 
@@ -519,24 +1503,64 @@ std::vector<uint> Instance::getSortedGWListByAvailableEd(uint ed) {
 
 std::vector<uint> Instance::getEDList(uint gw, uint sf) {
     // Returns all ED that can be connected to GW using only the given SF
-    std::vector<uint> edList;     
-    for(uint ed = 0; ed < this->edCount; ed++){        
-        const uint minSF = this->getMinSF(ed, gw);
-        const uint maxSF = this->getMaxSF(ed);
-        if(minSF <= sf && sf <= maxSF)
+    std::vector<uint> edList;
+    for(uint ed : this->getReachableEDSpan(gw, sf))
+        if(sf <= this->getMaxSF(ed))
             edList.push_back(ed);
-    }
     return edList;
 }
 
+const ClusterIndex& Instance::getClusters() {
+    std::call_once(this->clustersBuilt, [this] {this->clusters.reset(new ClusterIndex(this));});
+    return *this->clusters;
+}
+
+ClusterIndex::ClusterIndex(Instance* l) {
+    this->gwCount = l->gwCount;
+    this->edCount = l->edCount;
+    this->words = (this->edCount + 63) / 64;
+    this->bits.assign((size_t)SF_NUM*this->gwCount*this->words, 0);
+    this->coverage.assign((size_t)SF_NUM*this->words, 0);
+    for(uint g = 0; g < this->gwCount; g++)
+        for(uint sf = 7; sf <= 12; sf++)
+            for(uint ed : l->getEDSpan(g, sf))
+                for(uint s = sf+1; s <= 13; s++) // Every cluster with SF above the min SF
+                    this->getBits(g, s)[ed >> 6] |= (uint64_t) 1 << (ed & 63);
+    for(uint s = 8; s <= 13; s++){
+        uint64_t* covered = this->coverage.data() + (size_t)(s-8)*this->words;
+        for(uint g = 0; g < this->gwCount; g++){
+            const uint64_t* gwBits = this->getBits(g, s);
+            for(size_t w = 0; w < this->words; w++)
+                covered[w] |= gwBits[w];
+        }
+    }
+}
+
+uint ClusterIndex::firstUncovered(uint s, const std::vector<uint64_t>& mask) const {
+    const uint64_t* covered = s > 7 ? this->coverage.data() + (size_t)(std::min(s, 13u)-8)*this->words : nullptr; // Clusters are empty for s <= 7
+    for(size_t w = 0; w < this->words; w++){
+        const uint64_t uncovered = covered != nullptr ? mask[w] & ~covered[w] : mask[w];
+        if(uncovered != 0) return w*64 + __builtin_ctzll(uncovered);
+    }
+    return this->edCount;
+}
+
+uint ClusterIndex::firstUncovered(uint s) const {
+    std::vector<uint64_t> all(this->words, ~(uint64_t) 0);
+    if(this->edCount % 64 != 0) // Bits past the last ED
+        all.back() = ((uint64_t) 1 << (this->edCount % 64)) - 1;
+    return this->firstUncovered(s, all);
+}
+
+std::vector<uint64_t> ClusterIndex::getMask(const std::vector<uint>& eds) const {
+    std::vector<uint64_t> mask(this->words, 0);
+    for(uint ed : eds)
+        mask[ed >> 6] |= (uint64_t) 1 << (ed & 63);
+    return mask;
+}
+
 std::vector<uint> Instance::getAllEDList(uint gw, uint maxSF) {
-    // Returns all ED that can be connected to GW using given SF from 7 to maxSF
-    std::unordered_set<uint> edSet;
-    for(uint s = 7; s < maxSF; s++){
-        std::vector<uint> tempList = this->getEDList(gw, s);
-        for(uint ee = 0; ee < tempList.size(); ee++)
-            edSet.insert(tempList[ee]);
-    }
-    std::vector<uint> edList(edSet.begin(), edSet.end());
-    return edList;
-}
\ No newline at end of file
+    // Returns all ED that can be connected to GW using given SF from 7 to maxSF (excluded)
+    const IndexSpan span = this->getReachableEDSpan(gw, maxSF > 0 ? maxSF-1 : 0);
+    return std::vector<uint>(span.begin(), span.end());
+}
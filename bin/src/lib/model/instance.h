@@ -10,8 +10,20 @@
 #include <vector>
 #include <sstream>
 #include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
 #include <algorithm>
 #include <unordered_set>
+#include <unordered_map>
+#include <thread>
+#include <charconv>
+#include <memory>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "uf.h"
 
@@ -23,10 +35,25 @@
 #include "../random/custom.h"
 
 #define MAX_TRIES 100000
+#define TEXT_PARSER_MIN_CHUNK (1 << 20) // Minimum bytes per thread when parsing text instances
+
+// Binary instance file format
+#define INSTANCE_FILE_MAGIC "LWINSTB" // 7 chars + null terminator
+#define INSTANCE_FILE_VERSION 1
+#define INSTANCE_FILE_ALIGN 64 // Sections start at multiples of this value
+#define INSTANCE_FILE_POSITIONS 0x1 // Flag: file includes ED and GW positions
+#define INSTANCE_FILE_TRANSPOSE 0x2 // Flag: file includes the GW-major copy of the SF matrix
+#define INSTANCE_FILE_SPARSE 0x4 // Flag: SF section is an adjacency list instead of a matrix
+// Index cache (sidecar file with the derived indexes and presolve results of an instance file)
+#define INDEX_CACHE_MAGIC "LWINDEX" // 7 chars + null terminator
+#define INDEX_CACHE_VERSION 1
+#define INDEX_CACHE_EXTENSION ".idx" // Appended to the instance file name
+#define SF_UNREACHABLE 100 // Min SF value for ED-GW pairs out of range
+#define SF_MATRIX_ALIGN 64 // Alignment of in-memory SF matrices (cache line)
 
 enum POSDIST {UNIFORM, NORMAL, CLOUDS}; 
 enum PERIODIST {SOFT, MEDIUM, HARD, FIXED}; 
-enum INSTANCE_OUT_FORMAT {NONE, TXT, HTML, SVG, ALL};
+enum INSTANCE_OUT_FORMAT {NONE, TXT, HTML, SVG, ALL, BIN, IDX};
 
 struct InstanceConfig { // This is for instance generation
     uint mapSize; // Map size
@@ -37,6 +64,7 @@ struct InstanceConfig { // This is for instance generation
     POSDIST posDistribution; // Distribution of positions
     INSTANCE_OUT_FORMAT outputFormat; // Format of output file  
     uint fixedPeriod; // Fixed period (if PERIODIST == FIXED)
+    bool sparse; // Store only ED-GW pairs in range
 
     InstanceConfig(  // Default configuration parameters
         uint mapSize = 1000,
@@ -46,7 +74,8 @@ struct InstanceConfig { // This is for instance generation
         PERIODIST timeRequirement = SOFT,
         POSDIST posDistribution = UNIFORM,
         INSTANCE_OUT_FORMAT outputFormat = INSTANCE_OUT_FORMAT::NONE,
-        uint fixedPeriod = 3200
+        uint fixedPeriod = 3200,
+        bool sparse = false
     ) : 
         mapSize(mapSize),
         edNumber(edNumber),
@@ -55,7 +84,8 @@ struct InstanceConfig { // This is for instance generation
         timeRequirement(timeRequirement),
         posDistribution(posDistribution),
         outputFormat(outputFormat),
-        fixedPeriod(fixedPeriod) {}
+        fixedPeriod(fixedPeriod),
+        sparse(sparse) {}
 };
 
 // Models for the two tipes of nodes: end-devices and gateways
@@ -69,50 +99,262 @@ struct EndDevice {
     int period;
 };
 
+struct InstanceFileHeader { // Header of binary instance files (64 bytes)
+    char magic[8]; // INSTANCE_FILE_MAGIC
+    uint32_t version; // INSTANCE_FILE_VERSION
+    uint32_t flags; // INSTANCE_FILE_POSITIONS
+    uint32_t edCount;
+    uint32_t gwCount;
+    uint64_t sfOffset; // Min SF matrix, ED-major (uint8, edCount x gwCount). If sparse: offsets (uint64, edCount+1), GWs (uint32) and SFs (uint8) of pairs
+    uint64_t periodOffset; // ED periods (uint32, edCount)
+    uint64_t positionsOffset; // ED positions followed by GW positions (Position), 0 if not present
+    uint64_t fileSize; // Total file size, used to detect truncated files
+    uint64_t transposeOffset; // Min SF matrix, GW-major (uint8, gwCount x edCount), 0 if not present
+};
+static_assert(sizeof(InstanceFileHeader) == INSTANCE_FILE_ALIGN, "Binary instance header must be 64 bytes long");
+
+struct IndexCacheHeader { // Header of index cache files, followed by arrays (uint64 length + values)
+    char magic[8]; // INDEX_CACHE_MAGIC
+    uint32_t version; // INDEX_CACHE_VERSION
+    uint32_t edCount;
+    uint32_t gwCount;
+    uint32_t reserved;
+    uint64_t contentHash; // Hash of the instance the indexes were built from
+    uint64_t fileSize; // Total file size, used to detect truncated files
+};
+
+template <typename T, size_t Alignment>
+struct AlignedAllocator { // Allocator for std::vector with aligned storage
+    typedef T value_type;
+    template <typename U> struct rebind {typedef AlignedAllocator<U, Alignment> other;};
+    AlignedAllocator() = default;
+    template <typename U> AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+    T* allocate(size_t n) {
+        void* ptr = aligned_alloc(Alignment, (n*sizeof(T) + Alignment - 1) / Alignment * Alignment);
+        if(ptr == nullptr) throw std::bad_alloc();
+        return (T*) ptr;
+    }
+    void deallocate(T* ptr, size_t) {free(ptr);}
+    template <typename U> bool operator==(const AlignedAllocator<U, Alignment>&) const {return true;}
+    template <typename U> bool operator!=(const AlignedAllocator<U, Alignment>&) const {return false;}
+};
+
+typedef std::vector<uint8_t, AlignedAllocator<uint8_t, SF_MATRIX_ALIGN>> SFMatrixData;
+
+struct IndexSpan { // Non-owning view of a list of indexes (no allocations involved)
+    const uint* first;
+    const uint* last;
+    inline const uint* begin() const {return first;};
+    inline const uint* end() const {return last;};
+    inline size_t size() const {return last - first;};
+    inline bool empty() const {return first == last;};
+    inline uint operator[](size_t i) const {return first[i];};
+};
+
+struct PresolveInfo { // Problem structure shared by all solvers, computed once at load time
+    std::vector<uint> essentialEDs; // EDs with a single reachable GW (sorted)
+    std::vector<uint> essentialGWs; // GWs that are the only option of some ED (sorted)
+    std::vector<uint8_t> gwIsEssential; // 1 if GW is essential, for each GW
+    std::vector<uint8_t> forcedSF; // SF of each ED if min SF equals max SF on every reachable GW, else 0
+    std::vector<uint> uncoveredEDs; // EDs without reachable GWs
+    std::vector<uint> overloadedGWs; // Essential GWs that cannot serve all their essential EDs (UF >= 1)
+    inline bool isFeasible() const {return uncoveredEDs.empty() && overloadedGWs.empty();};
+};
+
+class Instance;
+
+class ClusterIndex { // Clusters of the greedy methods as bitsets: EDs that each GW reaches with SF lower than s (s = 8..13)
+    public:
+        ClusterIndex(Instance* l);
+
+        inline bool contains(uint gw, uint s, uint ed) const { // Same as ed in getAllEDList(gw, s)
+            if(s <= 7) return false;
+            return (this->getBits(gw, s)[ed >> 6] >> (ed & 63)) & 1;
+        };
+        // First ED of mask (one bit for each ED) that no GW reaches with SF lower than s, or edCount if there is none
+        uint firstUncovered(uint s, const std::vector<uint64_t>& mask) const;
+        uint firstUncovered(uint s) const; // Same, for all EDs
+        std::vector<uint64_t> getMask(const std::vector<uint>& eds) const; // Bitset with the given EDs
+
+    private:
+        uint gwCount, edCount;
+        size_t words; // 64 bit words of each bitset
+        std::vector<uint64_t> bits; // Bitset of each (s, GW)
+        std::vector<uint64_t> coverage; // Bitset of each s, OR of the bitsets of all GWs
+        inline const uint64_t* getBits(uint gw, uint s) const {
+            return this->bits.data() + ((size_t)(std::min(s, 13u)-8)*this->gwCount + gw)*this->words;
+        };
+        inline uint64_t* getBits(uint gw, uint s) {
+            return this->bits.data() + ((size_t)(std::min(s, 13u)-8)*this->gwCount + gw)*this->words;
+        };
+};
+
 class Instance { // Provides attributes and funcions related to problem formulation
     public:
         Instance(char* filename); // Load data from file
         Instance(const InstanceConfig& config = InstanceConfig()); // Generate from config
+        Instance(Instance* source, const std::vector<uint>& gwSubset); // Copy of source with a subset of its GWs
+        Instance(Instance* source, const std::vector<std::vector<uint>>& edGroups); // Copy of source with each group of EDs merged into a weighted ED
         ~Instance();
         
         void printRawData();
-        void exportRawData(const char* filename = nullptr);
+        void exportRawData(const char* filename = nullptr, bool sparse = false);
+        void exportBinaryData(const char* filename, bool sparse = false);
         void generateHtmlPlot(const char* filename);
         void generateSvgPlot(const char* filename);
         void copySFDataTo(std::vector<std::vector<uint>>& destination);
+        void exportIndexCache(const char* filename); // Writes indexes to filename + INDEX_CACHE_EXTENSION
+        uint64_t getContentHash(); // FNV-1a hash of dimensions, periods and min SF values
         
         uint gwCount, edCount;
         inline char* getInstanceFileName(){return this->instanceFileName;};
         inline uint sf2e(uint sf) {return this->pw[sf-7];};
-        uint getMinSF(uint ed, uint gw);
-        uint getMaxSF(uint ed);
-        UtilizationFactor getUF(uint ed, uint sf);
-        uint getPeriod(uint ed);
+        inline uint getMinSF(uint ed, uint gw) {
+            if(this->sfMatrix != nullptr) return this->sfMatrix[(size_t)ed*this->gwCount + gw];
+            return this->getSparseMinSF(ed, gw);
+        };
+        inline bool isSparse() {return this->adjOffsets != nullptr;};
+        // Dense backend only (nullptr if sparse)
+        inline const uint8_t* getSFRow(uint ed) {return this->sfMatrix + (size_t)ed*this->gwCount;}; // Min SF of ED for each GW
+        inline const uint8_t* getSFColumn(uint gw) {return this->sfMatrixT + (size_t)gw*this->edCount;}; // Min SF of each ED for GW
+        void copyRow(uint ed, uint8_t* row); // Min SF of ED for each GW (SF_UNREACHABLE if out of range), also for sparse instances
+        inline uint getMaxSF(uint ed) {return this->maxSFTable[ed];};
+        inline double getUFValue(uint ed, uint sf) {return this->ufTable[(size_t)(sf-7)*this->edCount + ed];};
+        inline const double* getUFValues(uint sf) {return this->ufTable.data() + (size_t)(sf-7)*this->edCount;}; // UF of every ED for this SF
+        inline UFFixed getUFFixed(uint ed, uint sf) {return this->ufFixedTable[(size_t)(sf-7)*this->edCount + ed];}; // Same UF in fixed-point
+        inline UtilizationFactor getUF(uint ed, uint sf) { // Invalid SF values are reported by UtilizationFactor
+            return UtilizationFactor(sf, sf-7 < SF_NUM ? this->getUFValue(ed, sf) : 0.0);
+        };
+        inline uint getPeriod(uint ed) {return this->periods[ed];};
+        inline bool isMapped() {return this->mappedFile != nullptr;};
         std::vector<uint> getGWList(uint ed);
         std::vector<uint> getSortedGWList(uint ed);
         std::vector<uint> getSortedGWListByAvailableEd(uint ed);
         std::vector<uint> getEDList(uint gw, uint sf);
         std::vector<uint> getAllEDList(uint gw, uint maxSF);
 
+        // Reachability indexes (CSR), built once at load time. Spans remain valid during the instance life
+        inline IndexSpan getGWSpan(uint ed) { // GWs in range of ED, sorted by min SF
+            return {this->edGWIndex.data() + this->edGWOffsets[ed], this->edGWIndex.data() + this->edGWOffsets[ed+1]};
+        };
+        inline uint getReachableGWCount(uint ed) {return this->edGWOffsets[ed+1] - this->edGWOffsets[ed];};
+        inline uint getReachableEDCount(uint gw) {return this->getReachableEDSpan(gw, 12).size();};
+        inline IndexSpan getEDSpan(uint gw, uint sf) { // EDs in range of GW whose min SF equals sf
+            if(sf < 7 || sf > 12) return {nullptr, nullptr};
+            const size_t bucket = (size_t)gw*SF_NUM + sf - 7;
+            return {this->gwEDIndex.data() + this->gwEDOffsets[bucket], this->gwEDIndex.data() + this->gwEDOffsets[bucket+1]};
+        };
+        inline IndexSpan getReachableEDSpan(uint gw, uint maxSF) { // EDs in range of GW with min SF up to maxSF
+            if(maxSF < 7) return {nullptr, nullptr};
+            const size_t first = (size_t)gw*SF_NUM;
+            const size_t last = first + (maxSF > 12 ? SF_NUM : maxSF - 6);
+            return {this->gwEDIndex.data() + this->gwEDOffsets[first], this->gwEDIndex.data() + this->gwEDOffsets[last]};
+        };
+
+        const ClusterIndex& getClusters(); // Built on first use
+
+        // GW reduction. Reduced instances keep the index of each GW in the original instance
+        std::vector<uint> getNonDominatedGWs();
+        Instance* reduceGateways(bool verbose = false);
+        inline uint getOriginalGW(uint gw) {return this->originalGW.empty() ? gw : this->originalGW[gw];};
+        inline uint getOriginalGWCount() {return this->originalGW.empty() ? this->gwCount : this->originalGWCount;};
+
+        // ED aggregation. Each ED of an aggregated instance is a class of identical EDs (same min SF row and period)
+        std::vector<std::vector<uint>> getIdenticalEDGroups();
+        Instance* aggregateEDs(bool verbose = false);
+        inline bool isAggregated() {return !this->edClass.empty();};
+        inline uint getWeight(uint ed) {return this->edWeights.empty() ? 1 : this->edWeights[ed];}; // Number of original EDs in the class
+        inline uint getEDClass(uint originalED) {return this->edClass.empty() ? originalED : this->edClass[originalED];};
+        inline uint getOriginalEDCount() {return this->edClass.empty() ? this->edCount : this->edClass.size();};
+        void expandSolution(const uint* gw, const uint* sf, uint* originalGW, uint* originalSF); // Class allocation to one value for each original ED
+
+        // Presolve results
+        inline const PresolveInfo& getPresolve() {return this->presolveInfo;};
+        inline bool isEssentialGW(uint gw) {return this->presolveInfo.gwIsEssential[gw];};
+        inline uint getForcedSF(uint ed) {return this->presolveInfo.forcedSF[ed];}; // 0 if SF is not forced
+        void printPresolveReport();
+
     private:
-        std::vector<std::vector<uint>> raw;
+        const uint8_t* sfMatrix; // Min SF of each (ED, GW) pair, ED-major. Points to sfData or to mapped file
+        const uint8_t* sfMatrixT; // Same matrix, GW-major. Points to sfDataT or to mapped file
+        const uint64_t* adjOffsets; // Sparse backend: first stored pair of each ED (edCount+1 values), nullptr if dense
+        const uint32_t* adjGW; // GW of each stored pair, sorted by GW for each ED
+        const uint8_t* adjSF; // Min SF of each stored pair
+        const uint32_t* periods; // Period of each ED. Points to periodData or to mapped file
+        SFMatrixData sfData; // Matrix storage when instance is generated or loaded from text file
+        SFMatrixData sfDataT; // Transposed matrix storage, unless mapped from file
+        std::vector<uint32_t> periodData;
+        std::vector<uint64_t> adjOffsetsData; // Sparse storage when instance is generated or loaded from text file
+        std::vector<uint32_t> adjGWData;
+        std::vector<uint8_t> adjSFData;
+        void* mappedFile; // Binary instance file mapped to memory (nullptr if not used)
+        size_t mappedSize;
+        std::vector<uint8_t> maxSFTable; // Max SF of each ED (from period)
+        std::vector<double> ufTable; // UF of each ED for each SF, SF-major (SF_NUM x edCount)
+        std::vector<UFFixed> ufFixedTable; // ufTable values in fixed-point, for capacity checks
+        std::vector<size_t> edGWOffsets; // CSR index ED -> reachable GWs (edCount+1 offsets)
+        std::vector<uint> edGWIndex;
+        std::vector<size_t> gwEDOffsets; // CSR index (GW, SF) -> reachable EDs with that min SF (gwCount*SF_NUM+1 offsets)
+        std::vector<uint> gwEDIndex;
+        PresolveInfo presolveInfo;
+        std::unique_ptr<ClusterIndex> clusters;
+        std::once_flag clustersBuilt;
+        std::vector<uint> originalGW; // Index of each GW in the original instance (empty if not reduced)
+        uint originalGWCount;
+        std::vector<uint> edWeights; // Size of each ED class (empty if not aggregated)
+        std::vector<uint> edClass; // Class of each original ED (empty if not aggregated)
         std::vector<EndDevice> eds; 
         std::vector<Position> gws; 
         char* instanceFileName;
         INSTANCE_OUT_FORMAT outputFormat;
         static const uint pw[6];
 
+        void loadTextFile(const char* filename);
+        bool loadBinaryFile(const char* filename);
+        void bindOwnedData(bool sparse);
+        void buildTranspose();
+        void buildTables();
+        void buildIndexes();
+        void presolve();
+        bool loadIndexCache(const char* filename);
+        uint getSparseMinSF(uint ed, uint gw);
+        uint64_t countPairs();
+        void sortPairs(uint64_t first, uint64_t last);
+        template <typename F> void forEachPair(uint ed, F f) { // Calls f(gw, minSF) for each stored pair (every GW if dense)
+            if(this->adjOffsets != nullptr){
+                for(uint64_t i = this->adjOffsets[ed]; i < this->adjOffsets[ed+1]; i++)
+                    f(this->adjGW[i], this->adjSF[i]);
+            }else{
+                const uint8_t* row = this->getSFRow(ed);
+                for(uint g = 0; g < this->gwCount; g++)
+                    f(g, row[g]);
+            }
+        };
         uint _getMaxSF(uint period);
         uint _getMinSF(double distance);
         uint _getMinSFScaled(double distance);
 };
 
+struct AllocationChange { // Journal entry: state of an ED before a connect or move
+    uint ed;
+    uint prevGW;
+    uint8_t prevSF;
+    bool wasConnected;
+    bool moved; // UF of the ED was removed from prevGW
+};
+
+struct AllocationSavepoint { // Journal sizes when the savepoint was taken
+    size_t changes;
+    size_t snapshots;
+};
+
 struct Allocation { // Models a candidate solution (allocation of gw and sf for each ed)
     std::vector<uint> gw;
 	std::vector<uint> sf;
     std::vector<bool> connected;
     uint connectedCount;
-    std::vector<UtilizationFactor> ufGW; // Total UF of each GW
+    std::vector<UtilizationFactor> ufGW; // Total UF of each GW (used by the objective)
+    GatewayLoad load; // Same values as ufGW in fixed-point, decides if a GW can take an ED
     Instance *l;
 
 	Allocation(Instance* l) {
@@ -121,9 +363,68 @@ struct Allocation { // Models a candidate solution (allocation of gw and sf for
         connected.resize(l->edCount, false);
         connectedCount = 0;
         ufGW.resize(l->gwCount, UtilizationFactor());
+        load = GatewayLoad(l->gwCount);
         this->l = l;
+        journaling = false;
+        epoch = 0;
 	}
 
+    // Journal: connections and moves are recorded, so they can be undone in O(changes) without copying the allocation.
+    // The current state becomes the base state restored by reset()
+    void beginJournal() {
+        journaling = true;
+        changes.clear();
+        snapshots.clear();
+        gwEpoch.assign(l->gwCount, 0);
+        epoch = 1;
+    }
+
+    inline AllocationSavepoint savepoint() {
+        epoch++; // GWs modified from now on get a new UF snapshot
+        return {changes.size(), snapshots.size()};
+    }
+
+    void rollback(const AllocationSavepoint& sp) { // Undo all changes made after sp, in reverse order
+        for(size_t i = changes.size(); i > sp.changes; i--){
+            const AllocationChange& c = changes[i-1];
+            const uint e = c.ed;
+            load.sub(gw[e], sf[e], l->getUFFixed(e, sf[e]));
+            if(c.moved)
+                load.add(c.prevGW, c.prevSF, l->getUFFixed(e, c.prevSF));
+            if(!c.wasConnected){
+                connected[e] = false;
+                connectedCount--;
+            }
+            gw[e] = c.prevGW;
+            sf[e] = c.prevSF;
+        }
+        for(size_t i = snapshots.size(); i > sp.snapshots; i--) // UF values are restored, not recomputed, so they are exact
+            ufGW[snapshots[i-1].first] = snapshots[i-1].second;
+        changes.resize(sp.changes);
+        snapshots.resize(sp.snapshots);
+        epoch++;
+    }
+
+    inline void reset() {rollback({0, 0});};
+
+    // Sets mask[g] = 1 for the GWs that reach ED e with min SF up to maxSF and can take it with that SF without
+    // becoming full (as checkUFAndConnect(e, g)). Returns the number of GWs found. All GWs are checked in one pass
+    uint getFittingGWs(uint e, uint maxSF, std::vector<uint8_t>& mask) {
+        UFFixed values[SF_NUM]; // UF of e for each SF
+        for(uint s = 0; s < SF_NUM; s++)
+            values[s] = l->getUFFixed(e, s+7);
+        const uint8_t* row;
+        if(l->isSparse()){
+            static thread_local std::vector<uint8_t> sparseRow;
+            sparseRow.resize(l->gwCount);
+            l->copyRow(e, sparseRow.data());
+            row = sparseRow.data();
+        }else
+            row = l->getSFRow(e);
+        mask.resize(l->gwCount);
+        return load.fits(row, values, std::min(maxSF, l->getMaxSF(e)), mask.data());
+    }
+
     void printAlloc() {
         std::cout << "Node allocation:" << std::endl;
         for(uint e = 0; e < l->edCount; e++)
@@ -139,13 +440,14 @@ struct Allocation { // Models a candidate solution (allocation of gw and sf for
     bool checkUFAndConnect(uint e, uint g, uint asf = 0, bool incremental = false) {
         uint sf2 = (asf == 0 ? l->getMinSF(e, g) : asf); // Use provided or min SF as default
         uint maxSF = l->getMaxSF(e);
-        UtilizationFactor nextUF;
         while(sf2 <= maxSF) {
-            nextUF = l->getUF(e, sf2); // UF of node e for g
-            if(!(ufGW[g] + nextUF).isFull()){ // If available UF, use it
+            const UFFixed nextUF = l->getUFFixed(e, sf2); // UF of node e for g
+            if(load.canTake(g, sf2, nextUF)){ // If available UF, use it
+                if(journaling) record(e, g, false);
                 gw[e] = g;
                 sf[e] = sf2;
-                ufGW[g] += nextUF;
+                ufGW[g] += l->getUF(e, sf2);
+                load.add(g, sf2, nextUF);
                 if(!connected[e]){ // May be previously connected
                     connected[e] = true;
                     connectedCount++;
@@ -164,12 +466,15 @@ struct Allocation { // Models a candidate solution (allocation of gw and sf for
         if(gw[e] != g && connected[e]){
             const uint sf2 = l->getMinSF(e, g);
             if(sf2 < sf[e]){ // If new SF is smaller
-                const UtilizationFactor nextUF = l->getUF(e, sf2); // UF of node e for g
-                if(!(ufGW[g] + nextUF).isFull()){ // If g available for e with sf2
+                const UFFixed nextUF = l->getUFFixed(e, sf2); // UF of node e for g
+                if(load.canTake(g, sf2, nextUF)){ // If g available for e with sf2
+                    if(journaling) record(e, g, true);
                     ufGW[gw[e]] -= l->getUF(e, sf[e]); // Substract previous UF to prev GW
+                    load.sub(gw[e], sf[e], l->getUFFixed(e, sf[e])); // Exact, restores the previous load of the GW
                     gw[e] = g;
                     sf[e] = sf2;
-                    ufGW[g] += nextUF;
+                    ufGW[g] += l->getUF(e, sf2);
+                    load.add(g, sf2, nextUF);
                     return true;
                 }
             }
@@ -177,6 +482,25 @@ struct Allocation { // Models a candidate solution (allocation of gw and sf for
         return false;
     }
 
+    private:
+        bool journaling;
+        std::vector<AllocationChange> changes;
+        std::vector<std::pair<uint, UtilizationFactor>> snapshots; // UF of a GW before its first change after a savepoint
+        std::vector<uint> gwEpoch; // Epoch of the last snapshot of each GW
+        uint epoch; // Incremented by savepoints and rollbacks
+
+        void record(uint e, uint g, bool moved) { // Called before connecting or moving e to g
+            changes.push_back({e, gw[e], (uint8_t) sf[e], connected[e], moved});
+            snapshotUF(g);
+            if(moved) snapshotUF(gw[e]);
+        }
+
+        inline void snapshotUF(uint g) {
+            if(gwEpoch[g] == epoch) return; // Already saved since the last savepoint
+            gwEpoch[g] = epoch;
+            snapshots.push_back({g, ufGW[g]});
+        }
+
     /*
     void connect(uint e, uint g, int asf = -1) { // Unvalidated operation
         const uint sf2 = (asf == -1 ? l->getMinSF(e, g) : asf); // Use provided or min SF as default
@@ -11,60 +11,45 @@ Objective::~Objective() {
 
 const uint Objective::unfeasibleIncrement = 10000;
 
-double Objective::eval(const uint* gw, const uint* sf, uint &gwCount, uint &energy, double &maxUF, bool &feasible) {    
-    // Reset objectives (if unfeasible solution, these values remain 0 and _DBL_MAX_ is returned)
-    gwCount = 0;
-    energy = 0;
-    maxUF = 0.0;
-    int feasibility = 0; // Feasibility type: 0->feasible, 1 -> no valid SF, 2 -> UF > 1 for some gw
-    double cost = 0.0; // Cost value have meaning when solutions are feasible, else will take large values
-
-    UtilizationFactor gwuf[this->instance->gwCount]; // Array of UF objects
-    std::fill(gwuf, gwuf + this->instance->gwCount, UtilizationFactor()); // Initialize all elements to 0.0 (all SF from 7 to 12)
-
-    for(uint i = 0; i < this->instance->edCount; i++){ // For each ED    
-        // Check if feasible SF
-        uint minSF = this->instance->getMinSF(i, gw[i]);
-        uint maxSF = this->instance->getMaxSF(i);
-        if(sf[i] > maxSF || sf[i] < minSF){ // Unfeasibility condition: not valid SF available for this GW
-            feasibility = 1;
-            //std::cout << "SF of ED " << i << " not valid." << std::endl;
-            cost += unfeasibleIncrement;
-        }
-
-        // Compute GW UF
-        gwuf[gw[i]] += this->instance->getUF(i, sf[i]);
-        if(gwuf[gw[i]].isFull()){ // Unfeasibility condition: UF > 1 for some SF
-            feasibility = 2;
-            //std::cout << "UF of GW " << gw[i] << " greater than 1" << std::endl;
-            //gwuf[gw[i]].printUFValues();
-            cost += unfeasibleIncrement;
-        }
-        double maxUFTemp = gwuf[gw[i]].getMax(); // Max UF value between all SF
-        if(maxUFTemp > maxUF) // Update max UF
-            maxUF = maxUFTemp;
-    }
-
-    // Count number of used gw
-    for(uint j = 0; j < this->instance->gwCount; j++)
-        if(gwuf[j].isUsed()) 
-            gwCount++;
+EvalStats Objective::getStats() const {
+    EvalStats stats;
+    stats.evals = this->counters.evals.load(std::memory_order_relaxed);
+    stats.feasibleEvals = this->counters.feasibleEvals.load(std::memory_order_relaxed);
+    stats.moves = this->counters.moves.load(std::memory_order_relaxed);
+    stats.evalTime = this->counters.evalNs.load(std::memory_order_relaxed) * 1e-6;
+    return stats;
+}
 
-    // Compute energy cost
-    for(uint i = 0; i < this->instance->edCount; i++) // For each ED
-        energy += this->instance->sf2e(sf[i]);// energy += pow(2, sf[i] - 7);
+void Objective::resetStats() {
+    this->counters.evals = 0;
+    this->counters.feasibleEvals = 0;
+    this->counters.moves = 0;
+    this->counters.evalNs = 0;
+}
 
-    feasible = feasibility == 0;
+EvalWorkspace& getEvalWorkspace() {
+    static thread_local EvalWorkspace workspace;
+    return workspace;
+}
 
-    // If solution is feasible, at this point (before following equation), cost should equal 0.0
-    cost += this->tp.alpha * (double) gwCount + 
-            this->tp.beta * (double) energy + 
-            this->tp.gamma * maxUF;
+double Objective::eval(const uint* gw, const uint* sf, uint &gwCount, uint &energy, double &maxUF, bool &feasible) {    
+    FEAS_CODE code;
+    const double cost = this->evalKernel<OBJ_MODE::WEIGHTED, FEAS_MODE::PENALTY>(gw, sf, gwCount, energy, maxUF, code);
+    feasible = code == FEAS_CODE::FEASIBLE;
+    return cost;
+}
 
-    return cost; 
+void Objective::evalBatch(uint count, const uint* gw, const uint* sf, EvalResults* results) {
+    // Candidates are independent, each worker evaluates whole candidates
+    const size_t edCount = this->instance->edCount;
+    ThreadPool::getDefault().parallelFor(count, [&](uint k) {
+        EvalResults& res = results[k];
+        res.cost = this->evalKernel<OBJ_MODE::WEIGHTED, FEAS_MODE::PENALTY>(gw + k*edCount, sf + k*edCount, res.gwUsed, res.energy, res.uf, res.unfeasibleCode);
+        res.feasible = res.unfeasibleCode == FEAS_CODE::FEASIBLE;
+    });
 }
 
-EvalResults Objective::eval(Allocation alloc, bool comparable) {
+EvalResults Objective::eval(const Allocation& alloc, bool comparable) {
     EvalResults res = {
         0, // gwUsed
         0, // energy
@@ -73,6 +58,7 @@ EvalResults Objective::eval(Allocation alloc, bool comparable) {
         0.0, // uf
         0.0 // cost
     };
+    const EvalScope scope(this->counters, res.unfeasibleCode);
 
     for(uint i = 0; i < this->instance->edCount; i++){ // For each ED
         if(alloc.connected[i]){
@@ -99,7 +85,7 @@ EvalResults Objective::eval(Allocation alloc, bool comparable) {
             if(maxUFTemp > res.uf) // Update max UF
                 res.uf = maxUFTemp;
 
-            res.energy += this->instance->sf2e(alloc.sf[i]);// energy += pow(2, sf[i] - 7);
+            res.energy += this->instance->getWeight(i) * this->instance->sf2e(alloc.sf[i]);// energy += pow(2, sf[i] - 7); (aggregated EDs count once per member)
         }else{
             res.feasible = false;
             res.cost += 3*unfeasibleIncrement;
@@ -122,6 +108,148 @@ EvalResults Objective::eval(Allocation alloc, bool comparable) {
     return res;
 }
 
+IncrementalEval::IncrementalEval(Objective* objective) {
+    this->objective = objective;
+    this->instance = objective->getInstance();
+    this->gw.resize(this->instance->edCount, 0);
+    this->sf.resize(this->instance->edCount, 7);
+}
+
+void IncrementalEval::reset(const uint* gw, const uint* sf) {
+    const uint gwCount = this->instance->gwCount;
+    this->ufGW.assign(gwCount, UtilizationFactor());
+    this->edsOfGW.assign(gwCount, 0);
+    this->maxTree.assign(2*gwCount, 0.0);
+    this->gwUsed = 0;
+    this->energy = 0;
+    this->invalidSFCount = 0;
+    this->overloadedCount = 0;
+    for(uint e = 0; e < this->instance->edCount; e++){
+        this->gw[e] = gw[e];
+        this->sf[e] = sf[e];
+        this->ufGW[gw[e]] += this->instance->getUF(e, sf[e]);
+        this->edsOfGW[gw[e]]++;
+        this->energy += this->instance->getWeight(e) * this->instance->sf2e(sf[e]);
+        if(!this->isValidSF(e)) this->invalidSFCount++;
+    }
+    for(uint g = 0; g < gwCount; g++){
+        if(this->ufGW[g].isUsed()) this->gwUsed++;
+        if(this->ufGW[g].isFull()) this->overloadedCount += this->edsOfGW[g];
+        this->maxTree[gwCount + g] = this->ufGW[g].getMax();
+    }
+    for(uint i = gwCount - 1; i > 0; i--)
+        this->maxTree[i] = std::max(this->maxTree[2*i], this->maxTree[2*i+1]);
+}
+
+bool IncrementalEval::isValidSF(uint ed) const {
+    return this->sf[ed] >= this->instance->getMinSF(ed, this->gw[ed]) && this->sf[ed] <= this->instance->getMaxSF(ed);
+}
+
+void IncrementalEval::attach(uint ed, int sign) {
+    const uint g = this->gw[ed];
+    UtilizationFactor& uf = this->ufGW[g];
+    // Remove previous contribution of the GW, update it and add the new one
+    if(uf.isUsed()) this->gwUsed--;
+    if(uf.isFull()) this->overloadedCount -= this->edsOfGW[g];
+    if(!this->isValidSF(ed)) this->invalidSFCount += sign;
+    const UtilizationFactor edUF = this->instance->getUF(ed, this->sf[ed]);
+    if(sign > 0) uf += edUF;
+    else uf -= edUF;
+    this->edsOfGW[g] += sign;
+    this->energy += sign * (int)(this->instance->getWeight(ed) * this->instance->sf2e(this->sf[ed]));
+    if(uf.isUsed()) this->gwUsed++;
+    if(uf.isFull()) this->overloadedCount += this->edsOfGW[g];
+    // Update path to the root of the max tree
+    uint i = this->instance->gwCount + g;
+    this->maxTree[i] = uf.getMax();
+    for(i /= 2; i > 0; i /= 2)
+        this->maxTree[i] = std::max(this->maxTree[2*i], this->maxTree[2*i+1]);
+}
+
+void IncrementalEval::relocate(uint ed, uint gw, uint sf) {
+    this->attach(ed, -1);
+    this->gw[ed] = gw;
+    this->sf[ed] = sf;
+    this->attach(ed, 1);
+}
+
+void IncrementalEval::move(uint ed, uint gw, uint sf) {
+    this->objective->counters.moves.fetch_add(1, std::memory_order_relaxed);
+    this->relocate(ed, gw, sf);
+}
+
+double IncrementalEval::moveCost(uint ed, uint gw, uint sf) {
+    this->objective->counters.moves.fetch_add(1, std::memory_order_relaxed);
+    const uint prevGW = this->gw[ed];
+    const uint prevSF = this->sf[ed];
+    this->relocate(ed, gw, sf);
+    const double cost = this->getCost();
+    this->relocate(ed, prevGW, prevSF);
+    return cost;
+}
+
+double IncrementalEval::getCost() const {
+    const TunningParameters& tp = this->objective->tp;
+    return (double) Objective::unfeasibleIncrement * (this->invalidSFCount + this->overloadedCount) +
+            tp.alpha * (double) this->gwUsed + 
+            tp.beta * (double) this->energy + 
+            tp.gamma * this->getMaxUF();
+}
+
+bool Incumbent::offer(double candidate) {
+    double current = this->cost.load(std::memory_order_relaxed);
+    while(candidate < current) // Retry if another thread changed the value
+        if(this->cost.compare_exchange_weak(current, candidate, std::memory_order_relaxed))
+            return true;
+    return false;
+}
+
+CostBound::CostBound(Objective* objective) {
+    this->objective = objective;
+    this->instance = objective->getInstance();
+    this->minEnergy.resize(this->instance->edCount);
+    this->totalMinEnergy = 0;
+    for(uint e = 0; e < this->instance->edCount; e++){
+        uint minSF = this->instance->getMaxSF(e);
+        for(uint g : this->instance->getGWSpan(e))
+            minSF = std::min(minSF, this->instance->getMinSF(e, g));
+        this->minEnergy[e] = this->instance->getWeight(e) * SF_ENERGY[std::min(minSF - SF_FIRST, (uint) SF_NUM - 1)];
+        this->totalMinEnergy += this->minEnergy[e];
+    }
+    this->reset();
+}
+
+void CostBound::reset() {
+    this->gwUsed = 0;
+    this->energy = 0;
+    this->pendingEnergy = this->totalMinEnergy;
+    this->maxUF = 0.0;
+}
+
+void CostBound::reset(const Allocation& alloc) {
+    this->reset();
+    for(uint e = 0; e < this->instance->edCount; e++)
+        if(alloc.connected[e]){
+            this->energy += this->instance->getWeight(e) * SF_ENERGY[alloc.sf[e] - SF_FIRST];
+            this->pendingEnergy -= this->minEnergy[e];
+        }
+    for(uint g = 0; g < this->instance->gwCount; g++){
+        if(alloc.ufGW[g].isUsed())
+            this->gwUsed++;
+        this->maxUF = std::max(this->maxUF, alloc.ufGW[g].getMax());
+    }
+}
+
+void CostBound::connect(uint ed, uint sf, const UtilizationFactor& gwUF, bool wasUsed) {
+    if(!wasUsed && gwUF.isUsed())
+        this->gwUsed++;
+    this->energy += this->instance->getWeight(ed) * SF_ENERGY[sf - SF_FIRST];
+    this->pendingEnergy -= this->minEnergy[ed];
+    const double gwMax = gwUF.getMax();
+    if(gwMax > this->maxUF)
+        this->maxUF = gwMax;
+}
+
 void Objective::printSolution(const uint* gw, const uint* sf, bool allocation, bool highlight, bool showGWs, std::ostream& os){
     
     uint gwCount;
@@ -141,16 +269,17 @@ void Objective::printSolution(const uint* gw, const uint* sf, bool allocation, b
                 << ",U=" << maxUF
                 << ")" << std::endl;
     
-    if(showGWs) {
+    if(showGWs) { // GW indexes refer to the original instance if it was reduced
         std::vector<uint> gwList; // Gws used
         for(uint i = 0; i < edCount; i++) {
-            auto it = std::find(gwList.begin(), gwList.end(), gw[i]);
+            const uint g = this->instance->getOriginalGW(gw[i]);
+            auto it = std::find(gwList.begin(), gwList.end(), g);
             if(it == gwList.end()){ // If the gw of node "i" isnt in list
-                gwList.push_back(gw[i]);
+                gwList.push_back(g);
             }
         }
         std::vector<uint> gwList2; // Gws not used
-        for (uint gi = 0; gi < this->instance->gwCount; gi++) {
+        for (uint gi = 0; gi < this->instance->getOriginalGWCount(); gi++) {
             auto it = std::find(gwList.begin(), gwList.end(), gi);
             if(it == gwList.end()){ // If the gw of node "i" isnt in list
                 gwList2.push_back(gi);
@@ -171,7 +300,7 @@ void Objective::printSolution(const uint* gw, const uint* sf, bool allocation, b
         os << "Allocation (GW[SF]):" << std::endl;
         for(uint i = 0; i < edCount; i++){ // For each ED    
             if(i % 10 == 0) os << std::endl;
-            os << gw[i] << "[" << sf[i] << "]\t";
+            os << this->instance->getOriginalGW(gw[i]) << "[" << sf[i] << "]\t";
         }
         os << std::endl;
     }
@@ -179,7 +308,7 @@ void Objective::printSolution(const uint* gw, const uint* sf, bool allocation, b
     if(highlight) os << "\033[0m\n"; // Switch to normal text font
 }
 
-void Objective::printSolution(const Allocation alloc, const EvalResults results, bool allocation, bool highlight, bool showGWs, std::ostream& os) {
+void Objective::printSolution(const Allocation& alloc, const EvalResults& results, bool allocation, bool highlight, bool showGWs, std::ostream& os) {
 
     if(highlight) os << "\033[1;31m"; // Switch to red font
     
@@ -195,12 +324,13 @@ void Objective::printSolution(const Allocation alloc, const EvalResults results,
             std::vector<uint> gwList; // Used
             std::vector<uint> gwList2; // Unused
             for(uint i = 0; i < alloc.gw.size(); i++){
-                auto it = std::find(gwList.begin(), gwList.end(), alloc.gw[i]);
+                const uint g = this->instance->getOriginalGW(alloc.gw[i]);
+                auto it = std::find(gwList.begin(), gwList.end(), g);
                 if(it == gwList.end()){ // If the gw of node "i" isnt in list
-                    gwList.push_back(alloc.gw[i]);
+                    gwList.push_back(g);
                 }
             }
-            for (uint gi = 0; gi < this->instance->gwCount; gi++) {
+            for (uint gi = 0; gi < this->instance->getOriginalGWCount(); gi++) {
                 auto it = std::find(gwList.begin(), gwList.end(), gi);
                 if(it == gwList.end()){ // If the gw of node "i" isnt in list
                     gwList2.push_back(gi);
@@ -220,7 +350,7 @@ void Objective::printSolution(const Allocation alloc, const EvalResults results,
             os << "Allocation (GW[SF]):" << std::endl;
             for(uint i = 0; i < alloc.gw.size(); i++){ // For each ED    
                 if(i % 10 == 0) os << std::endl;
-                os << alloc.gw[i] << "[" << alloc.sf[i] << "]\t";
+                os << this->instance->getOriginalGW(alloc.gw[i]) << "[" << alloc.sf[i] << "]\t";
             }
             os << std::endl;
         }
@@ -241,13 +371,19 @@ void Objective::exportWST(const uint* gw, const uint* sf, std::ostream& os) {
             << "    writeLevel=\"2\"/>" << std::endl
             << "  <variables>" << std::endl;
 
+    // Variables are indexed by GWs of the original instance (if it was reduced)
+    const uint gwCount = this->instance->getOriginalGWCount();
+    std::vector<uint> originalGW(this->instance->edCount);
+    for(uint e = 0; e < this->instance->edCount; e++)
+        originalGW[e] = this->instance->getOriginalGW(gw[e]);
+
     uint index = 3;
     uint lastch = 0;
     bool selected;
-    for(uint g = 1; g < this->instance->gwCount+1; g++){
+    for(uint g = 1; g < gwCount+1; g++){
         selected = false;
         for(uint e = 0; e < this->instance->edCount; e++){
-            if(gw[e] == g-1){
+            if(originalGW[e] == g-1){
                 selected = true;
                 break;
             }
@@ -264,9 +400,9 @@ void Objective::exportWST(const uint* gw, const uint* sf, std::ostream& os) {
     }
 
     for(uint e = 1; e < this->instance->edCount+1; e++)
-        for(uint g = this->instance->gwCount; g > 0 ; g--)   
+        for(uint g = gwCount; g > 0 ; g--)   
             for(uint s = 12; s >= 7; s--){
-                selected = gw[e-1] == g-1 && sf[e-1] == s;
+                selected = originalGW[e-1] == g-1 && sf[e-1] == s;
                 os << "    <variable name=\"x#" 
                         << e << "#" << g << "#" << s
                         << "\" index=\"" << index
@@ -289,7 +425,8 @@ void logResultsToCSV(const OptimizationResults results, const char* csvfilename)
     }
 
     if (csvFile.tellp() == 0) { // File is empty, write the header
-        csvFile << "Instance Name,Alpha,Beta,Gamma,Solver,Execution Time (ms),Cost,Feasible,GW Used,Energy,UF" << std::endl;
+        csvFile << "Instance Name,Alpha,Beta,Gamma,Solver,Execution Time (ms),Cost,Feasible,GW Used,Energy,UF,"
+                << "Evaluations,Evaluations/s,Feasible Evaluations,Move Evaluations,Evaluation Time (ms),Construction Time (ms)" << std::endl;
     }
     
     csvFile << results.instanceName << ","
@@ -302,7 +439,13 @@ void logResultsToCSV(const OptimizationResults results, const char* csvfilename)
             << (results.feasible ? "Yes,":"No,")
             << results.gwUsed << ","
             << results.energy << ","
-            << results.uf << std::endl;
+            << results.uf << ","
+            << results.stats.evals << ","
+            << (results.execTime > 0 ? results.stats.evals * 1000.0 / results.execTime : 0) << ","
+            << results.stats.feasibleEvals << ","
+            << results.stats.moves << ","
+            << results.stats.evalTime << ","
+            << std::max(0.0, results.execTime - results.stats.evalTime) << std::endl; // Time out of evaluations
 
     csvFile.flush();
     csvFile.close();
@@ -11,11 +11,19 @@
 
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include "../util/util.h"
+#include "../util/threadpool.h"
 #include "uf.h"
 #include "instance.h"
 
 enum FEAS_CODE {FEASIBLE, SF_RANGE, UF_VALUE, ED_COVERAGE};
+enum OBJ_MODE {WEIGHTED, GW_ONLY, ENERGY_ONLY, UF_ONLY}; // Objective computed by Objective::evalKernel
+enum FEAS_MODE {PENALTY, EARLY_EXIT}; // Penalize each violation (comparable costs) or stop at the first one
+
+constexpr uint SF_FIRST = 7; // Lowest SF, SF_NUM values from here
+constexpr uint SF_ENERGY[SF_NUM] = {1, 2, 4, 8, 16, 32}; // Time window of each SF, 2^(SF-7)
 
 struct TunningParameters {
     double alpha;
@@ -31,6 +39,13 @@ struct TunningParameters {
         gamma(gamma) {}
 };
 
+struct EvalStats { // Evaluation counters of an Objective
+    unsigned long long evals = 0; // Full evaluations
+    unsigned long long feasibleEvals = 0;
+    unsigned long long moves = 0; // Move evaluations of IncrementalEval
+    double evalTime = 0.0; // Time spent in full evaluations (ms). Added over threads
+};
+
 struct OptimizationResults {
     bool ready; // Valid content flag
     char* instanceName; // Instance input file name
@@ -42,6 +57,7 @@ struct OptimizationResults {
     bool feasible; // Feasible solution
     double uf; // Max. utilization factor of solution
     TunningParameters tp; // alpha, beta, gamma
+    EvalStats stats; // Evaluations done by the solver
 
     void print(int detailLevel = 0) {
         switch (detailLevel)
@@ -66,6 +82,10 @@ struct OptimizationResults {
                 std::cout << "  Energy: " << energy << std::endl;
                 std::cout << "  Feasible: " << (feasible ? "Yes" : "No") << std::endl;
                 std::cout << "  Max UF: " << uf << std::endl;
+                std::cout << "  Evaluations: " << stats.evals << " (" << stats.feasibleEvals << " feasible, " 
+                        << (execTime > 0 ? stats.evals * 1000.0 / execTime : 0) << " per second)" << std::endl;
+                std::cout << "  Move evaluations: " << stats.moves << std::endl;
+                std::cout << "  Evaluation time: " << stats.evalTime << " ms" << std::endl;
                 std::cout << "  Tunning parameters:" << std::endl;
                 std::cout << "    Alpha: " << tp.alpha << std::endl;
                 std::cout << "    Beta: " << tp.beta << std::endl;
@@ -87,24 +107,208 @@ struct EvalResults {
     double cost; // Objective cost
 };
 
+struct EvalWorkspace { // Buffers reused by the evaluations of each thread, so solver loops do not allocate memory
+    std::vector<UtilizationFactor> gwuf; // UF of each GW
+    std::vector<uint> gw; // Allocation arrays for callers that build them (e.g. from chromosomes)
+    std::vector<uint> sf;
+    std::vector<EvalResults> results;
+};
+
+EvalWorkspace& getEvalWorkspace(); // Workspace of the calling thread
+
 class Objective {
     public:
         Objective(Instance* instance, const TunningParameters& tp = TunningParameters());
         ~Objective();
         
         double eval(const uint* gw, const uint* sf, uint &gwCount, uint &energy, double &totalUF, bool &feasible);
-        EvalResults eval(Allocation alloc, bool comparable = false);
+        // Evaluation specialized at compile time. Only the objectives of the mode are computed, the rest are left as 0.
+        // With EARLY_EXIT, unfeasible allocations return unfeasibleIncrement and no objective values.
+        // eval uses <WEIGHTED, PENALTY>
+        template <OBJ_MODE mode, FEAS_MODE feasMode>
+        double evalKernel(const uint* gw, const uint* sf, uint &gwCount, uint &energy, double &maxUF, FEAS_CODE &code);
+        EvalResults eval(const Allocation& alloc, bool comparable = false);
+        // Evaluates count candidates stored one after the other (gw[k*edCount + e] is the GW of ED e in candidate k)
+        void evalBatch(uint count, const uint* gw, const uint* sf, EvalResults* results);
 
         void printSolution(const uint* gw, const uint* sf, bool allocation = true, bool highlight = false, bool showGWs = false, std::ostream& os = std::cout);
-        void printSolution(const Allocation alloc, const EvalResults results, bool allocation = true, bool highlight = false, bool showGWs = false, std::ostream& os = std::cout);
+        void printSolution(const Allocation& alloc, const EvalResults& results, bool allocation = true, bool highlight = false, bool showGWs = false, std::ostream& os = std::cout);
         void exportWST(const uint* gw, const uint* sf, std::ostream& os = std::cout);
 
         TunningParameters tp;
 
         inline Instance *getInstance() const { return instance; }
+
+        EvalStats getStats() const; // Counters since construction or last resetStats
+        void resetStats();
+
     private:
         Instance* instance;
         static const uint unfeasibleIncrement;
+        friend class IncrementalEval;
+
+        struct EvalCounters { // Relaxed atomics, evaluations may run in several threads
+            std::atomic<unsigned long long> evals{0};
+            std::atomic<unsigned long long> feasibleEvals{0};
+            std::atomic<unsigned long long> moves{0};
+            std::atomic<unsigned long long> evalNs{0};
+        } counters;
+
+        class EvalScope { // Counts one full evaluation and its time when the evaluation returns
+            public:
+                EvalScope(EvalCounters& counters, const FEAS_CODE& code) : 
+                    counters(counters), code(code), start(std::chrono::steady_clock::now()) {};
+                ~EvalScope() {
+                    const auto elapsed = std::chrono::steady_clock::now() - this->start;
+                    this->counters.evalNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), std::memory_order_relaxed);
+                    this->counters.evals.fetch_add(1, std::memory_order_relaxed);
+                    if(this->code == FEAS_CODE::FEASIBLE)
+                        this->counters.feasibleEvals.fetch_add(1, std::memory_order_relaxed);
+                };
+            private:
+                EvalCounters& counters;
+                const FEAS_CODE& code;
+                const std::chrono::steady_clock::time_point start;
+        };
+};
+
+template <OBJ_MODE mode, FEAS_MODE feasMode>
+double Objective::evalKernel(const uint* gw, const uint* sf, uint &gwCount, uint &energy, double &maxUF, FEAS_CODE &code) {
+    constexpr bool needGW = mode == OBJ_MODE::WEIGHTED || mode == OBJ_MODE::GW_ONLY;
+    constexpr bool needEnergy = mode == OBJ_MODE::WEIGHTED || mode == OBJ_MODE::ENERGY_ONLY;
+    constexpr bool needUF = mode == OBJ_MODE::WEIGHTED || mode == OBJ_MODE::UF_ONLY;
+
+    gwCount = 0;
+    energy = 0;
+    maxUF = 0.0;
+    code = FEAS_CODE::FEASIBLE;
+    double cost = 0.0; // Cost value have meaning when solutions are feasible, else will take large values
+    const EvalScope scope(this->counters, code);
+
+    const uint edCount = this->instance->edCount;
+    const uint gwTotal = this->instance->gwCount;
+    std::vector<UtilizationFactor>& gwuf = getEvalWorkspace().gwuf; // Array of UF objects
+    gwuf.assign(gwTotal, UtilizationFactor());
+
+    for(uint i = 0; i < edCount; i++){ // For each ED
+        if(sf[i] > this->instance->getMaxSF(i) || sf[i] < this->instance->getMinSF(i, gw[i])){ // Not valid SF for this GW
+            code = FEAS_CODE::SF_RANGE;
+            if constexpr (feasMode == FEAS_MODE::EARLY_EXIT) return unfeasibleIncrement;
+            cost += unfeasibleIncrement;
+        }
+        UtilizationFactor& uf = gwuf[gw[i]];
+        uf += this->instance->getUF(i, sf[i]);
+        if(uf.isFull()){ // UF > 1 for some SF
+            code = FEAS_CODE::UF_VALUE;
+            if constexpr (feasMode == FEAS_MODE::EARLY_EXIT) return unfeasibleIncrement;
+            cost += unfeasibleIncrement;
+        }
+    }
+
+    if constexpr (needGW || needUF){ // UF values only grow, so the max of the final UFs is the max reached by any GW
+        for(uint j = 0; j < gwTotal; j++){
+            if constexpr (needGW)
+                if(gwuf[j].isUsed())
+                    gwCount++;
+            if constexpr (needUF){
+                const double gwMax = gwuf[j].getMax();
+                if(gwMax > maxUF)
+                    maxUF = gwMax;
+            }
+        }
+    }
+
+    if constexpr (needEnergy)
+        for(uint i = 0; i < edCount; i++){ // Aggregated EDs count once per member
+            const uint s = sf[i] - SF_FIRST;
+            energy += this->instance->getWeight(i) * (s < SF_NUM ? SF_ENERGY[s] : 0);
+        }
+
+    if constexpr (mode == OBJ_MODE::WEIGHTED)
+        cost += this->tp.alpha * (double) gwCount + this->tp.beta * (double) energy + this->tp.gamma * maxUF;
+    else if constexpr (mode == OBJ_MODE::GW_ONLY)
+        cost += (double) gwCount;
+    else if constexpr (mode == OBJ_MODE::ENERGY_ONLY)
+        cost += (double) energy;
+    else
+        cost += maxUF;
+
+    return cost;
+}
+
+class IncrementalEval { // Keeps the objective values of an allocation and updates them on single ED moves
+    public:
+        IncrementalEval(Objective* objective);
+
+        void reset(const uint* gw, const uint* sf); // Full evaluation, O(E + G)
+        void move(uint ed, uint gw, uint sf); // O(log G)
+        double moveCost(uint ed, uint gw, uint sf); // Cost after moving ED, state is not modified. O(log G)
+
+        // Same values as Objective::eval for feasible allocations. Unfeasible ones are penalized once 
+        // for each ED with invalid SF and for each ED connected to a full GW
+        double getCost() const;
+        inline uint getGWUsed() const {return this->gwUsed;};
+        inline uint getEnergy() const {return this->energy;};
+        inline double getMaxUF() const {return this->maxTree[1];};
+        inline bool isFeasible() const {return this->invalidSFCount == 0 && this->overloadedCount == 0;};
+        inline uint getGW(uint ed) const {return this->gw[ed];};
+        inline uint getSF(uint ed) const {return this->sf[ed];};
+
+    private:
+        Objective* objective;
+        Instance* instance;
+        std::vector<uint> gw;
+        std::vector<uint> sf;
+        std::vector<UtilizationFactor> ufGW; // UF of each GW
+        std::vector<uint> edsOfGW; // Number of EDs connected to each GW
+        std::vector<double> maxTree; // Max UF of each GW (leaves from gwCount) and max of each subtree. Root is maxTree[1]
+        uint gwUsed;
+        uint energy;
+        uint invalidSFCount; // EDs whose SF is out of range for its GW
+        uint overloadedCount; // EDs connected to full GWs
+
+        void attach(uint ed, int sign); // Adds (sign=1) or removes (sign=-1) ED from its GW
+        void relocate(uint ed, uint gw, uint sf); // move without counting it
+        bool isValidSF(uint ed) const;
+};
+
+class Incumbent { // Cost of the best feasible solution found so far. Can be shared by threads solving the same instance
+    public:
+        Incumbent() : cost(__DBL_MAX__) {};
+        inline double get() const {return this->cost.load(std::memory_order_relaxed);};
+        bool offer(double candidate); // Keeps candidate if it is lower. Returns true if it was kept
+
+    private:
+        std::atomic<double> cost;
+};
+
+class CostBound { // Lower bound of the cost of a feasible allocation while EDs are being connected
+    public:
+        CostBound(Objective* objective);
+
+        void reset(); // No ED connected
+        void reset(const Allocation& alloc); // Connected EDs of alloc
+        // Called after connecting ed with sf. gwUF is the UF of its GW after the connection, wasUsed tells if the GW was used before
+        void connect(uint ed, uint sf, const UtilizationFactor& gwUF, bool wasUsed);
+
+        // GW count, energy and max UF only grow when EDs are connected. EDs not connected yet add their lowest energy.
+        // When all EDs are connected, this is the cost returned by Objective::eval
+        inline double get() const {
+            return this->objective->tp.alpha * (double) this->gwUsed + 
+                    this->objective->tp.beta * (double) (this->energy + this->pendingEnergy) + 
+                    this->objective->tp.gamma * this->maxUF;
+        };
+        inline bool exceeds(const Incumbent& incumbent) const {return this->get() >= incumbent.get();}; // Cannot improve incumbent
+
+    private:
+        Objective* objective;
+        Instance* instance;
+        std::vector<uint> minEnergy; // Energy of each ED with the lowest SF among its reachable GWs
+        uint totalMinEnergy;
+        uint gwUsed;
+        uint energy; // Energy of connected EDs
+        uint pendingEnergy; // Lowest energy of EDs not connected
+        double maxUF;
 };
 
 void logResultsToCSV(const OptimizationResults results, const char* csvfilename);
@@ -1,23 +1,8 @@
+#include <cstring>
 #include "uf.h"
 
-// Default constructor
-UtilizationFactor::UtilizationFactor() {
-    for (uint i = 0; i < SF_NUM; i++)
-        this->ufValues[i] = 0.0;
-}
-
-// Constructor with single SF value
-UtilizationFactor::UtilizationFactor(uint sf, double ufValue) {
-    if (sf-7 < SF_NUM){ 
-        for (uint i = 0; i < SF_NUM; i++)
-            this->ufValues[i] = (i == (sf-7) ? ufValue : 0.0);
-    }else{
-        std::cerr << "Invalid SF index. SF = " << sf << std::endl;
-    }
-}
-
 // Constructor with initializer list
-UtilizationFactor::UtilizationFactor(std::initializer_list<double> values) {
+UtilizationFactor::UtilizationFactor(std::initializer_list<double> values) : UtilizationFactor() {
     if (values.size() != SF_NUM) {
         std::cerr << "Error: Invalid number of UF values provided." << std::endl;
         return;
@@ -30,57 +15,12 @@ UtilizationFactor::UtilizationFactor(std::initializer_list<double> values) {
     }
 }
 
-// Check if any component has not available utilization
-bool UtilizationFactor::isFull() const {
-    for (int i = 0; i < SF_NUM; i++)
-        if (ufValues[i] >= 1.0)
-            return true;
-    return false;
-}
-
-// Check if at least one of UF values is used
-bool UtilizationFactor::isUsed() const {
-    for (int i = 0; i < SF_NUM; i++)
-        if (ufValues[i] > UFTHRES)
-            return true;
-    return false;
-}
-
-// Get max UF between all SFs
-double UtilizationFactor::getMax() const {
-    double maxValue = 0.0;
-    for (int i = 0; i < SF_NUM; i++)
-        if (this->ufValues[i] >= maxValue)
-            maxValue = this->ufValues[i];
-    return maxValue;
-}
-
 void UtilizationFactor::setSFValue(uint sf, double ufValue) {
     if (sf-7 < SF_NUM) 
         ufValues[sf-7] = ufValue;
     else
         std::cerr << "Invalid SF index. SF = " << sf << std::endl;
 }
-// Summation operator
-UtilizationFactor UtilizationFactor::operator+(const UtilizationFactor& other) const {
-    UtilizationFactor result;
-    for (int i = 0; i < SF_NUM; i++)
-        result.ufValues[i] = this->ufValues[i] + other.ufValues[i];
-    return result;
-}
-
-UtilizationFactor& UtilizationFactor::operator+=(const UtilizationFactor& other) {
-    for (int i = 0; i < SF_NUM; i++)
-        this->ufValues[i] += other.ufValues[i];
-    return *this;
-}
-
-UtilizationFactor& UtilizationFactor::operator-=(const UtilizationFactor& other) {
-    for (int i = 0; i < SF_NUM; i++)
-        this->ufValues[i] -= other.ufValues[i];
-    return *this;
-}
-
 // Comparison operators
 bool UtilizationFactor::operator==(const UtilizationFactor& other) const {
     for (int i = 0; i < SF_NUM; i++)
@@ -117,4 +57,46 @@ void UtilizationFactor::printUFValues() {
     for (int i = 1; i < SF_NUM; i++)
         std::cout << ", " << this->ufValues[i];
     std::cout << std::endl;
-}
\ No newline at end of file
+}
+
+GatewayLoad::GatewayLoad(uint gwCount) {
+    this->gwCount = gwCount;
+    this->stride = (gwCount + 3) & ~3u;
+    this->rows.assign((size_t)SF_NUM*this->stride, 0);
+}
+
+uint GatewayLoad::fits(const uint8_t* minSF, const UFFixed* values, uint maxSF, uint8_t* mask) const {
+    uint count = 0;
+    uint g = 0;
+#ifdef __AVX2__
+    // 4 GWs at a time: the load of the row of the min SF of each GW is gathered and must stay below 1 with the UF
+    // of the ED. Sums are below 2^63, so signed comparisons are valid
+    const __m256i one = _mm256_set1_epi64x((long long) UF_FIXED_ONE);
+    const __m256i low = _mm256_set1_epi64x(6);
+    const __m256i high = _mm256_set1_epi64x((long long) maxSF + 1);
+    const __m256i stride = _mm256_set1_epi64x(this->stride);
+    const __m256i lanes = _mm256_setr_epi64x(0, 1, 2, 3);
+    for (; g + 4 <= this->gwCount; g += 4) {
+        int32_t packed;
+        memcpy(&packed, minSF + g, sizeof(packed));
+        const __m256i sf = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(packed));
+        const __m256i inRange = _mm256_and_si256(_mm256_cmpgt_epi64(sf, low), _mm256_cmpgt_epi64(high, sf));
+        const __m256i k = _mm256_and_si256(inRange, _mm256_sub_epi64(sf, _mm256_set1_epi64x(7))); // 0 if not in range
+        const __m256i index = _mm256_add_epi64(_mm256_mul_epu32(k, stride), _mm256_add_epi64(_mm256_set1_epi64x(g), lanes));
+        const __m256i row = _mm256_i64gather_epi64((const long long*) this->rows.data(), index, 8);
+        const __m256i value = _mm256_i64gather_epi64((const long long*) values, k, 8);
+        const __m256i ok = _mm256_and_si256(inRange, _mm256_cmpgt_epi64(one, _mm256_add_epi64(row, value)));
+        const int bits = _mm256_movemask_pd(_mm256_castsi256_pd(ok));
+        for (uint i = 0; i < 4; i++)
+            mask[g+i] = (bits >> i) & 1;
+        count += __builtin_popcount(bits);
+    }
+#endif
+    for (; g < this->gwCount; g++) {
+        const uint sf = minSF[g];
+        const bool ok = sf >= 7 && sf <= maxSF && this->canTake(g, sf, values[sf-7]);
+        mask[g] = ok;
+        count += ok;
+    }
+    return count;
+}
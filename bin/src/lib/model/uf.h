@@ -2,27 +2,47 @@
 #define UF_H
 
 #include <iostream>
+#include <vector>
+#include <cstdint>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 // UF value for a GW to be considered as "used"
 #define UFTHRES 1e-6
 #define SF_NUM 6
+#define UF_PADDED_NUM 8 // SF values plus two zeros, so each UF fills two 256 bit registers
+#define UF_ALIGN 32
+
+// Fixed-point UF used for capacity checks: integer sums are exact, so adding and removing an ED restores the same value
+typedef uint64_t UFFixed;
+#define UF_FIXED_BITS 48
+constexpr UFFixed UF_FIXED_ONE = (UFFixed) 1 << UF_FIXED_BITS;
+inline UFFixed toFixedUF(double value) { // Rounded up, so a GW below capacity in fixed-point is also below with exact values
+    if (value >= 1.0) return UF_FIXED_ONE; // Never fits, and keeps sums far from overflow
+    const double scaled = value * (double) UF_FIXED_ONE; // Exact scaling (power of 2)
+    UFFixed fixed = (UFFixed) scaled;
+    return fixed + ((double) fixed < scaled);
+}
+inline double fromFixedUF(UFFixed value) {return (double) value / (double) UF_FIXED_ONE;}
 
 class UtilizationFactor {
 public:
-    UtilizationFactor();
-    UtilizationFactor(uint sf, double ufValue);
+    inline UtilizationFactor();
+    inline UtilizationFactor(uint sf, double ufValue);
     UtilizationFactor(std::initializer_list<double> values);
     
-    bool isFull() const;
-    bool isUsed() const;
-    double getMax() const;
+    // Hot operations are defined below, so they can be inlined. Padding values are always 0
+    inline bool isFull() const;
+    inline bool isUsed() const;
+    inline double getMax() const;
 
     void setSFValue(uint sf, double ufValue);
 
     // Logic and algebraic operators for UF
-    UtilizationFactor operator+(const UtilizationFactor& other) const;
-    UtilizationFactor& operator+=(const UtilizationFactor& other);
-    UtilizationFactor& operator-=(const UtilizationFactor& other);
+    inline UtilizationFactor operator+(const UtilizationFactor& other) const;
+    inline UtilizationFactor& operator+=(const UtilizationFactor& other);
+    inline UtilizationFactor& operator-=(const UtilizationFactor& other);
     bool operator==(const UtilizationFactor& other) const;
     bool operator!=(const UtilizationFactor& other) const;
     bool operator<(const UtilizationFactor& other) const;
@@ -35,7 +55,124 @@ public:
     void printUFValues();
 
 private:
-    double ufValues[SF_NUM];
+    alignas(UF_ALIGN) double ufValues[UF_PADDED_NUM];
+};
+
+#ifdef __AVX2__ // Built with "make AVX2=1"
+
+inline UtilizationFactor& UtilizationFactor::operator+=(const UtilizationFactor& other) {
+    _mm256_store_pd(this->ufValues, _mm256_add_pd(_mm256_load_pd(this->ufValues), _mm256_load_pd(other.ufValues)));
+    _mm256_store_pd(this->ufValues + 4, _mm256_add_pd(_mm256_load_pd(this->ufValues + 4), _mm256_load_pd(other.ufValues + 4)));
+    return *this;
+}
+
+inline UtilizationFactor& UtilizationFactor::operator-=(const UtilizationFactor& other) {
+    _mm256_store_pd(this->ufValues, _mm256_sub_pd(_mm256_load_pd(this->ufValues), _mm256_load_pd(other.ufValues)));
+    _mm256_store_pd(this->ufValues + 4, _mm256_sub_pd(_mm256_load_pd(this->ufValues + 4), _mm256_load_pd(other.ufValues + 4)));
+    return *this;
+}
+
+inline bool UtilizationFactor::isFull() const { // Any value >= 1
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d full = _mm256_or_pd(
+        _mm256_cmp_pd(_mm256_load_pd(this->ufValues), one, _CMP_GE_OQ), 
+        _mm256_cmp_pd(_mm256_load_pd(this->ufValues + 4), one, _CMP_GE_OQ));
+    return _mm256_movemask_pd(full) != 0;
+}
+
+inline bool UtilizationFactor::isUsed() const { // Any value > UFTHRES
+    const __m256d thres = _mm256_set1_pd(UFTHRES);
+    const __m256d used = _mm256_or_pd(
+        _mm256_cmp_pd(_mm256_load_pd(this->ufValues), thres, _CMP_GT_OQ), 
+        _mm256_cmp_pd(_mm256_load_pd(this->ufValues + 4), thres, _CMP_GT_OQ));
+    return _mm256_movemask_pd(used) != 0;
+}
+
+inline double UtilizationFactor::getMax() const { // Padding zeros keep the result >= 0, as the scalar version
+    const __m256d m = _mm256_max_pd(_mm256_load_pd(this->ufValues), _mm256_load_pd(this->ufValues + 4));
+    const __m128d m2 = _mm_max_pd(_mm256_castpd256_pd128(m), _mm256_extractf128_pd(m, 1));
+    return _mm_cvtsd_f64(_mm_max_sd(m2, _mm_unpackhi_pd(m2, m2)));
+}
+
+#else // Scalar version, loops over the padded array can still be vectorized by the compiler
+
+inline UtilizationFactor& UtilizationFactor::operator+=(const UtilizationFactor& other) {
+    for (int i = 0; i < UF_PADDED_NUM; i++)
+        this->ufValues[i] += other.ufValues[i];
+    return *this;
+}
+
+inline UtilizationFactor& UtilizationFactor::operator-=(const UtilizationFactor& other) {
+    for (int i = 0; i < UF_PADDED_NUM; i++)
+        this->ufValues[i] -= other.ufValues[i];
+    return *this;
+}
+
+inline bool UtilizationFactor::isFull() const { // Check if any component has not available utilization
+    bool full = false;
+    for (int i = 0; i < UF_PADDED_NUM; i++)
+        full |= this->ufValues[i] >= 1.0;
+    return full;
+}
+
+inline bool UtilizationFactor::isUsed() const { // Check if at least one of UF values is used
+    bool used = false;
+    for (int i = 0; i < UF_PADDED_NUM; i++)
+        used |= this->ufValues[i] > UFTHRES;
+    return used;
+}
+
+inline double UtilizationFactor::getMax() const { // Max UF between all SFs
+    double maxValue = 0.0;
+    for (int i = 0; i < UF_PADDED_NUM; i++)
+        maxValue = this->ufValues[i] > maxValue ? this->ufValues[i] : maxValue;
+    return maxValue;
+}
+
+#endif
+
+inline UtilizationFactor::UtilizationFactor() { // All values (and padding) to 0
+    for (int i = 0; i < UF_PADDED_NUM; i++)
+        this->ufValues[i] = 0.0;
+}
+
+inline UtilizationFactor::UtilizationFactor(uint sf, double ufValue) : UtilizationFactor() { // Single SF value
+    if (sf-7 < SF_NUM)
+        this->ufValues[sf-7] = ufValue;
+    else
+        std::cerr << "Invalid SF index. SF = " << sf << std::endl;
+}
+
+inline UtilizationFactor UtilizationFactor::operator+(const UtilizationFactor& other) const {
+    UtilizationFactor result = *this;
+    result += other;
+    return result;
+}
+
+class GatewayLoad { // UF of all GWs in fixed-point, stored by SF (one contiguous row of GWs for each SF)
+public:
+    GatewayLoad(uint gwCount = 0);
+
+    inline double get(uint gw, uint sf) const {return fromFixedUF(this->rows[(size_t)(sf-7)*this->stride + gw]);};
+    inline void add(uint gw, uint sf, UFFixed value) {
+        if (sf-7 < SF_NUM) this->rows[(size_t)(sf-7)*this->stride + gw] += value;
+    };
+    inline void sub(uint gw, uint sf, UFFixed value) {
+        if (sf-7 < SF_NUM) this->rows[(size_t)(sf-7)*this->stride + gw] -= value;
+    };
+    // Values are only added after this check, so the other SFs of the GW are already below 1 and only one row is read
+    inline bool canTake(uint gw, uint sf, UFFixed value) const {
+        return sf-7 < SF_NUM && this->rows[(size_t)(sf-7)*this->stride + gw] + value < UF_FIXED_ONE;
+    };
+
+    // Sets mask[g] = 1 if 7 <= minSF[g] <= maxSF and canTake(g, minSF[g], values[minSF[g]-7]).
+    // Returns the number of GWs found
+    uint fits(const uint8_t* minSF, const UFFixed* values, uint maxSF, uint8_t* mask) const;
+
+private:
+    uint gwCount;
+    uint stride; // Row length, gwCount rounded up to 4 values
+    std::vector<UFFixed> rows;
 };
 
 #endif // UF_H
\ No newline at end of file
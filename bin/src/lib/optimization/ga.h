@@ -16,13 +16,21 @@ class EdGene : public Gene { // End device: has a GW and a SF. Needs to know its
 
         inline void randomize() override {
             Instance *l = o->getInstance();
-            std::vector<uint> gwList = l->getGWList(index); // Valid gw for this ed
+            const IndexSpan gwList = l->getGWSpan(index); // GWs in range, sorted by min SF
+            const uint maxSF = l->getMaxSF(index);
+            unsigned int validCount = 0; // Valid gws for this ed are the ones with min SF up to max SF
+            while(validCount < gwList.size() && l->getMinSF(index, gwList[validCount]) <= maxSF)
+                validCount++;
+            if(validCount == 0) { // No available gws for this ed
+                std::cerr << "Error: Unfeasible system. An End-Device cannot be connected to any Gateway given its period." << std::endl
+                          << "ED = " << index << std::endl;
+                exit(1);
+            }
             // Pick random gw
-            const unsigned int gwIndex = uniform.random(gwList.size());
+            const unsigned int gwIndex = uniform.random(validCount);
             gw = gwList[gwIndex]; 
             // Pick random SF from valid range
             const uint minSF = l->getMinSF(index, gw);
-            const uint maxSF = l->getMaxSF(index);
             //sf = minSF + rand() % (maxSF - minSF + 1);
             sf = uniform.random(minSF, maxSF);
         }
@@ -74,16 +82,28 @@ class AllocationChromosome : public Chromosome { // Network allocation (GW and S
         }
 
         void getPhenotype(double &cost, uint &gwCount, uint &energy, double &totalUF, bool &feasible) const {
+            // Evaluate cost and objectives
+            fillAllocation();
+            cost = o->eval(getEvalWorkspace().gw.data(), getEvalWorkspace().sf.data(), gwCount, energy, totalUF, feasible);
+        }
+
+        template <OBJ_MODE mode, FEAS_MODE feasMode>
+        double evalPhenotype(uint &gwCount, uint &energy, double &totalUF, FEAS_CODE &code) const { // See Objective::evalKernel
+            fillAllocation();
+            return o->evalKernel<mode, feasMode>(getEvalWorkspace().gw.data(), getEvalWorkspace().sf.data(), gwCount, energy, totalUF, code);
+        }
+
+        void fillAllocation() const { // Writes the gw and sf arrays of the genes to the evaluation workspace
             unsigned int edCount = genes.size();
-            uint* gw = new uint[edCount];
-            uint* sf = new uint[edCount];
+            std::vector<uint>& gw = getEvalWorkspace().gw;
+            std::vector<uint>& sf = getEvalWorkspace().sf;
+            gw.resize(edCount);
+            sf.resize(edCount);
             for (unsigned int i = 0; i < edCount; i++) {
                 EdGene* gene = (EdGene*) genes[i];
                 gw[i] = gene->getGW();
                 sf[i] = gene->getSF();
             }
-            // Evaluate cost and objectives
-            cost = o->eval(gw, sf, gwCount, energy, totalUF, feasible);
         }
 
         void setGeneValue(uint index, uint gw, uint sf){
@@ -107,8 +127,8 @@ class AllocationChromosome : public Chromosome { // Network allocation (GW and S
         }
 
         void clone(const Chromosome* other) { // Copy the genes from another chromosome
-            std::vector<Gene*> otherGenes = other->getGenes();
-            std::vector<Gene*> thisGenes = getGenes();
+            const std::vector<Gene*>& otherGenes = other->getGenes();
+            const std::vector<Gene*>& thisGenes = getGenes();
             for (unsigned int i = 0; i < otherGenes.size(); i++) {
                 EdGene *thisGene = (EdGene*) thisGenes[i];
                 EdGene *otherGene = (EdGene*) otherGenes[i];
@@ -135,30 +155,50 @@ class GAFitness : public Fitness { // Cost fitness function
             return "Network Fitness";
         }
 
-        void evaluate(Chromosome *chromosome) const override {
-            // Get gw and sf arrays
-            std::vector<Gene*> genes = chromosome->getGenes();
-            unsigned int edCount = genes.size();
-            uint* gw = new uint[edCount];
-            uint* sf = new uint[edCount];
-            for (unsigned int i = 0; i < edCount; i++) {
-                EdGene* gene = (EdGene*) genes[i];
-                gw[i] = gene->getGW();
-                sf[i] = gene->getSF();
-            }
+        void evaluate(Chromosome *chromosome) const override { // Same result as a batch of one, without building the batch
+            AllocationChromosome* ch = (AllocationChromosome*) chromosome;
 
-            // Evaluate cost
+            double cost;
             uint gwCount;
             uint energy;
             double totalUF;
             bool feasible;
-            double cost = o->eval(gw, sf, gwCount, energy, totalUF, feasible);
+            ch->getPhenotype(cost, gwCount, energy, totalUF, feasible);
             // Inverse cost for maximization
-            double inverseCost = feasible ? 1e3/cost : 0;
-            chromosome->fitness = inverseCost;
+            chromosome->fitness = feasible ? 1e3/cost : 0;
             chromosome->objectives = {(double) gwCount, (double) energy, totalUF};
         }
 
+        void evaluateBatch(const std::vector<Chromosome*>& chromosomes) const override {
+            // Get gw and sf arrays of all chromosomes, one after the other
+            const unsigned int count = chromosomes.size();
+            const unsigned int edCount = o->getInstance()->edCount;
+            EvalWorkspace& workspace = getEvalWorkspace();
+            std::vector<uint>& gw = workspace.gw;
+            std::vector<uint>& sf = workspace.sf;
+            std::vector<EvalResults>& results = workspace.results;
+            gw.resize((size_t)count*edCount);
+            sf.resize((size_t)count*edCount);
+            results.resize(count);
+            for (unsigned int k = 0; k < count; k++) {
+                const std::vector<Gene*>& genes = chromosomes[k]->getGenes();
+                for (unsigned int i = 0; i < edCount; i++) {
+                    EdGene* gene = (EdGene*) genes[i];
+                    gw[(size_t)k*edCount + i] = gene->getGW();
+                    sf[(size_t)k*edCount + i] = gene->getSF();
+                }
+            }
+
+            // Evaluate cost
+            o->evalBatch(count, gw.data(), sf.data(), results.data());
+            for (unsigned int k = 0; k < count; k++) {
+                // Inverse cost for maximization
+                const EvalResults& res = results[k];
+                chromosomes[k]->fitness = res.feasible ? 1e3/res.cost : 0;
+                chromosomes[k]->objectives = {(double) res.gwUsed, (double) res.energy, res.uf};
+            }
+        }
+
         AllocationChromosome* generateChromosome(CROSS_METHOD cm) const override {
             AllocationChromosome* ch = new AllocationChromosome(o);
             switch (cm) {
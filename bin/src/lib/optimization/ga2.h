@@ -21,7 +21,7 @@ class GWAllocationChromosome : public Chromosome { // Network allocation (GW and
                 gwList.push_back(std::vector<EdSf>());
             }            
             for(uint ed = 0; ed < l->edCount; ed++) {
-                std::vector<uint> reachableGWs = l->getGWList(ed); // Valid gws for this ed
+                const IndexSpan reachableGWs = l->getGWSpan(ed); // Valid gws for this ed
                 if(reachableGWs.size() == 0) {
                     std::cout << "No GW for ED " << ed << std::endl;
                     exit(1);
@@ -57,9 +57,22 @@ class GWAllocationChromosome : public Chromosome { // Network allocation (GW and
             //std::cout << "Evaluating phenotype" << std::endl;
 
             // Evaluate cost and objectives
+            fillAllocation();
+            cost = o->eval(getEvalWorkspace().gw.data(), getEvalWorkspace().sf.data(), gwCount, energy, totalUF, feasible);
+        }
+
+        template <OBJ_MODE mode, FEAS_MODE feasMode>
+        double evalPhenotype(uint &gwCount, uint &energy, double &totalUF, FEAS_CODE &code) const { // See Objective::evalKernel
+            fillAllocation();
+            return o->evalKernel<mode, feasMode>(getEvalWorkspace().gw.data(), getEvalWorkspace().sf.data(), gwCount, energy, totalUF, code);
+        }
+
+        void fillAllocation() const { // Writes the gw and sf arrays of the phenotype to the evaluation workspace
             uint edCount = o->getInstance()->edCount;
-            uint* gw = new uint[edCount];
-            uint* sf = new uint[edCount];
+            std::vector<uint>& gw = getEvalWorkspace().gw;
+            std::vector<uint>& sf = getEvalWorkspace().sf;
+            gw.resize(edCount);
+            sf.resize(edCount);
             for (uint i = 0; i < edCount; i++) {
                 gw[i] = -1;
                 sf[i] = -1;
@@ -74,7 +87,7 @@ class GWAllocationChromosome : public Chromosome { // Network allocation (GW and
             Instance *l = o->getInstance();
             for (uint e = 0; e < edCount; e++) {
                 if(gw[e] == -1) {
-                    std::vector<uint> glist = l->getGWList(e); // Valid gws for this ed
+                    const IndexSpan glist = l->getGWSpan(e); // Valid gws for this ed
                     const uint randgw = rand() % glist.size();
                     const uint minSF = l->getMinSF(e, glist[randgw]);
                     const uint maxSF = l->getMaxSF(e);
@@ -84,8 +97,6 @@ class GWAllocationChromosome : public Chromosome { // Network allocation (GW and
                     std::this_thread::sleep_for(std::chrono::nanoseconds(50));
                 }
             }
-
-            cost = o->eval(gw, sf, gwCount, energy, totalUF, feasible);
         }
 
         void pushElToGene(uint gw, EdSf edSf) { // Add an ED to a GW
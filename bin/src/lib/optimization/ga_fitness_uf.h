@@ -15,25 +15,28 @@ class GAFitnessUF : public Fitness { // Cost fitness function
         }
 
         void evaluate(Chromosome *chromosome) const override {
-            // Get gw and sf arrays
-            std::vector<Gene*> genes = chromosome->getGenes();
-            unsigned int edCount = genes.size();
-            uint* gw = new uint[edCount];
-            uint* sf = new uint[edCount];
-            for (unsigned int i = 0; i < edCount; i++) {
-                EdGene* gene = (EdGene*) genes[i];
-                gw[i] = gene->getGW();
-                sf[i] = gene->getSF();
-            }
+            AllocationChromosome* ch = (AllocationChromosome*) chromosome;
 
-            // Evaluate cost
+            // Evaluate only the objective of this fitness, unfeasible chromosomes stop at the first violation
             uint gwCount;
             uint energy;
             double totalUF;
-            bool feasible;
-            o->eval(gw, sf, gwCount, energy, totalUF, feasible);
+            FEAS_CODE code;
+            ch->evalPhenotype<OBJ_MODE::UF_ONLY, FEAS_MODE::EARLY_EXIT>(gwCount, energy, totalUF, code);
             // Inverse cost for maximization
-            chromosome->fitness = feasible ? 1e3/totalUF : 0;
+            chromosome->fitness = code == FEAS_CODE::FEASIBLE ? 1e3/totalUF : 0;
+            chromosome->objectives = {(double) gwCount, (double) energy, totalUF};
+        }
+
+        void evaluateObjectives(Chromosome *chromosome) const override { // All objectives, for reported chromosomes
+            AllocationChromosome* ch = (AllocationChromosome*) chromosome;
+
+            uint gwCount;
+            uint energy;
+            double totalUF;
+            bool feasible;
+            double cost;
+            ch->getPhenotype(cost, gwCount, energy, totalUF, feasible);
             chromosome->objectives = {(double) gwCount, (double) energy, totalUF};
         }
 
@@ -69,19 +72,15 @@ class GWGAFitnessUF : public Fitness { // Cost fitness function
         }
 
         void evaluate(Chromosome *chromosome) const override {
-            const unsigned int edCount = o->getInstance()->edCount;
-            uint* gw = new uint[edCount];
-            uint* sf = new uint[edCount];
-
             GWAllocationChromosome* ch = (GWAllocationChromosome*) chromosome;
 
             uint gwCount;
             uint energy;
             double totalUF;
-            bool feasible;
-            double cost;
-            ch->getPhenotype(cost, gwCount, energy, totalUF, feasible);
-            chromosome->fitness = feasible ? 1e3/totalUF : 0;
+            FEAS_CODE code;
+            // One pass gives the fitness and all the objectives of the same phenotype (unassigned EDs are filled at random)
+            ch->evalPhenotype<OBJ_MODE::WEIGHTED, FEAS_MODE::PENALTY>(gwCount, energy, totalUF, code);
+            chromosome->fitness = code == FEAS_CODE::FEASIBLE ? 1e3/totalUF : 0;
             chromosome->objectives = {(double) gwCount, (double) energy, totalUF};
         }
 
@@ -17,6 +17,10 @@ OptimizationResults greedy(Instance* l, Objective* o, uint iters, uint timeout,
 OptimizationResults greedy4(Instance* l, Objective* o, uint iters, uint timeout, bool verbose = false, bool wst = false);
 OptimizationResults greedy8(Instance* l, Objective* o, uint iters, uint timeout, bool verbose = false, bool wst = false);
 
+// Local search over a feasible allocation (updated in place): moves EDs to used GWs with lower SF and closes GWs, 
+// least loaded GWs first, until no move improves the cost. Returns the number of GWs closed plus EDs moved
+uint reallocate(Instance* l, Objective* o, uint* gw, uint* sf, bool verbose = false);
+
 /*
 OptimizationResults greedy1(Instance* l, Objective* o, MIN minimize, bool verbose = false, bool wst = false);
 OptimizationResults greedy2(Instance* l, Objective* o, bool verbose = false, bool wst = false);
@@ -14,39 +14,18 @@ OptimizationResults greedy4(Instance* l, Objective* o, uint iters, uint timeout,
     bool feasibleFound = false;    
     uint gwBest[edCount];
     uint sfBest[edCount];
-    double minimumCost = __DBL_MAX__;
+    Incumbent incumbent; // Cost of the best allocation
+    CostBound bound(o); // Partial cost of the allocation being built
 
-    std::vector<std::vector<std::vector<uint>>> clusters; // Clusters tensor (SF x GW x ED)
-    clusters.resize(6); // Initialize list of matrices (GW x ED)
+    const ClusterIndex& clusters = l->getClusters(); // Clusters tensor (SF x GW x ED) as bitsets
     for(uint s = 7; s <= 12; s++){
         
-        // Build cluster matrix for this SF
-        for(uint g = 0; g < gwCount; g++)
-            clusters[s-7].push_back(l->getAllEDList(g ,s));
-        
         // Check if SF has coverage
-        bool hasCoverage = true; // This is updated if an ED cannot be assigned to any GW
-        for(uint e = 0; e < edCount; e++){
-            bool hasGW = false;
-            for(uint g = 0; g < gwCount; g++){
-                /* Find if ED "e" is present in the "clusters" tensor
-                for(uint ee = 0; ee < clusters[s-7][g].size(); ee++){
-                    if(clusters[s-7][g][ee] == e){
-                        hasGW = true;
-                        break;
-                    }
-                }
-                */
-                auto it = std::find(clusters[s-7][g].begin(), clusters[s-7][g].end(), e);
-                hasGW = (it != clusters[s-7][g].end());
-                if(hasGW) break;
-            }
-            if(!hasGW){ 
-                hasCoverage = false;
-                if(verbose) std::cout << "No coverage for SF " << s << ": ED " << e << " cannot be assigned to any GW." << std::endl;
-                if(s == 12) exit(1);
-                break;
-            }
+        const uint uncovered = clusters.firstUncovered(s); // edCount if every ED can be assigned to some GW
+        const bool hasCoverage = uncovered == edCount;
+        if(!hasCoverage){ 
+            if(verbose) std::cout << "No coverage for SF " << s << ": ED " << uncovered << " cannot be assigned to any GW." << std::endl;
+            if(s == 12) exit(1);
         }
 
         if(!hasCoverage) continue; // Next SF
@@ -69,22 +48,24 @@ OptimizationResults greedy4(Instance* l, Objective* o, uint iters, uint timeout,
                 // Start allocation of EDs one by one
                 bool allEDAllocated = true;
                 std::vector<UtilizationFactor> gwuf(gwCount); // Utilization factors of gws
+                bound.reset();
                 for(uint e = 0; e < edCount; e++){ 
                     bool edAllocated = false;
                     for(uint gi = 0; gi < gwCount; gi++){
                         const uint g = gwList[gi];
                         // Check if ED e can be connected to GW g
-                        auto it = std::find(clusters[s-7][g].begin(), clusters[s-7][g].end(), e);
-                        if((it != clusters[s-7][g].end()) && !gwuf[g].isFull()){
+                        if(clusters.contains(g, s, e) && !gwuf[g].isFull()){
                             uint minsf = l->getMinSF(e, g);
                             gw[e] = g;
                             sf[e] = minsf; // Always assign lower SF
+                            const bool wasUsed = gwuf[g].isUsed();
                             gwuf[g] += l->getUF(e, minsf);
+                            bound.connect(e, minsf, gwuf[g], wasUsed);
                             edAllocated = true;
                             break; // Go to next ed
                         }
                     }
-                    if(!edAllocated){
+                    if(!edAllocated || bound.exceeds(incumbent)){ // Not connected or cannot improve the best allocation
                         allEDAllocated = false;
                         break;
                     }
@@ -95,8 +76,7 @@ OptimizationResults greedy4(Instance* l, Objective* o, uint iters, uint timeout,
                 uint gwUsed, energy; double uf; bool feasible;
                 const double cost = o->eval(gw, sf, gwUsed, energy, uf, feasible);
 
-                if(feasible && cost < minimumCost){ // New optimum
-                    minimumCost = cost;
+                if(feasible && incumbent.offer(cost)){ // New optimum
                     std::copy(gw, gw + edCount, gwBest);
                     std::copy(sf, sf + edCount, sfBest);
                     feasibleFound = true;
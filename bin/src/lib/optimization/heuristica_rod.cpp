@@ -4,85 +4,99 @@
 OptimizationResults heuristica_rod(Instance* l, Objective* o, uint iters, uint timeout, bool verbose, bool wst){
 
     auto start = std::chrono::high_resolution_clock::now();
-    bool feasibleFound = false;    
     const uint gwCount = l->gwCount;
     const uint edCount = l->edCount;
-    uint gwBest[edCount];
-    uint sfBest[edCount];
+    std::vector<uint> gwBest(edCount, 0);
+    std::vector<uint> sfBest(edCount, 0);
 
-    
-    std::vector<std::vector<uint>> S(edCount, std::vector<uint>(gwCount+1));
-    for (uint e = 0; e < edCount; e++){
-        const uint maxSF = l->getMaxSF(e);
-        for (uint g = 0; g < gwCount; g++){
-            const uint minSF = l->getMinSF(e, g);
-            S[e][g] = maxSF >= minSF ? minSF : 100;
-        }
-    }
+    // Opens GWs and assigns them the EDs they reach (with their min SF, lowest first) that are not assigned yet and fit in 
+    // the GW: essential GWs first, then the GW that reaches most unassigned EDs, until none of them can be assigned.
+    // Counts of unassigned EDs are updated when EDs are assigned (O(E·G) overall instead of O(G²·E))
 
-    std::vector<uint> A(edCount, 0);
-    std::vector<uint> G(gwCount, 0);
+    std::vector<uint> reachable(edCount, 0); // GWs of the span of each ED with min SF up to its max SF (a prefix)
+    std::vector<uint> count(gwCount, 0); // Unassigned EDs in range of each GW
     for (uint e = 0; e < edCount; e++)
-        A[e] = l->getGWList(e).size();
-    for (uint g = 0; g < gwCount; g++)
-        G[g] = l->getEDList(g, 12).size();
-
-    std::vector<uint> E(gwCount, 0);
-    for (uint e = 0; e < edCount; e++) 
-        if (A[e] == 1)
-            for (uint g = 0; g < gwCount; g++)
-                if (S[e][g] < 100)
-                    E[g] = 1;
-
-    std::vector<std::vector<uint>> GW(gwCount, std::vector<uint>(edCount, 0));
-    for (uint g = 0; g < gwCount; g++)
-        if (E[g] == 1) 
-            for (uint e = 0; e < edCount; e++)
-                if (S[e][g] < 100) {
-                    GW[g][e] = S[e][g];
-                    for (uint k = 0; k < gwCount; k++)
-                        S[e][k] = 100;
-                }
+        for (uint g : l->getGWSpan(e)) {
+            if (l->getMinSF(e, g) > l->getMaxSF(e)) break; // Span is sorted by min SF
+            reachable[e]++;
+            count[g]++;
+        }
 
-    while (std::accumulate(E.begin(), E.end(), 0) < (int) edCount) {
-        uint maxG = 0;
-        uint longitud = 0;
-        for (uint g = 0; g < gwCount; g++) {
-            if (E[g] == 0) {
-                uint count = std::count_if(S.begin(), S.end(), [g, edCount](const auto& row) {
-                    return row[g] < edCount;
-                });
-                if (longitud < count) {
-                    maxG = g;
-                    longitud = count;
+    // Bucket queue: unopened GWs sorted by count, bucket[c] is the index of the first one with count c. A decrement
+    // swaps the GW with the first one of its bucket, so it is O(1) and the last GW has the max count
+    std::vector<uint> order(gwCount);
+    std::vector<uint> position(gwCount);
+    std::vector<uint> bucket(edCount + 2, 0);
+    uint active = 0; // Unopened GWs in order
+
+    std::vector<bool> opened(gwCount, false);
+    std::vector<bool> assigned(edCount, false);
+    uint assignedCount = 0;
+    uint gwOpened = 0;
+    GatewayLoad load(gwCount);
+    auto open = [&](uint g) { // Assigns the unassigned EDs in range of g that fit in it
+        opened[g] = true;
+        gwOpened++;
+        for (uint e : l->getReachableEDSpan(g, 12)) {
+            if (assigned[e] || l->getMinSF(e, g) > l->getMaxSF(e)) continue;
+            const uint s = l->getMinSF(e, g);
+            const UFFixed uf = l->getUFFixed(e, s);
+            if (!load.canTake(g, s, uf)) continue; // Left for other GWs
+            load.add(g, s, uf);
+            assigned[e] = true;
+            assignedCount++;
+            gwBest[e] = g;
+            sfBest[e] = s;
+            const IndexSpan span = l->getGWSpan(e);
+            for (uint k = 0; k < reachable[e]; k++){
+                const uint g2 = span[k];
+                if (opened[g2]) continue;
+                if (active > 0) { // Move g2 to the previous bucket
+                    const uint first = bucket[count[g2]]++;
+                    const uint other = order[first];
+                    order[position[g2]] = other;
+                    position[other] = position[g2];
+                    order[first] = g2;
+                    position[g2] = first;
                 }
+                count[g2]--;
             }
         }
-        if (maxG == 0) break;
-        E[maxG] = 1;
-        for (uint e = 0; e < edCount; e++)
-            if (S[e][maxG] < edCount) {
-                GW[maxG][e] = S[e][maxG];
-                for (uint k = 0; k < gwCount; k++)
-                    S[e][k] = edCount;
-            }
-    }
-
-    uint eng = 0;
-    for (uint g = 0; g < gwCount; g++)
-        for (uint e = 0; e < edCount; e++)
-            if (GW[g][e] > 0)
-                eng += std::pow(2, GW[g][e] - 7);
+    };
 
-    uint CG = std::accumulate(E.begin(), E.end(), 0);    
-    std::cout << "CG: " << CG << std::endl; // 8
-    std::cout << "Eng: " << eng << std::endl; // 485
+    for (uint g : l->getPresolve().essentialGWs)
+        if (!opened[g]) open(g);
 
+    for (uint g = 0; g < gwCount; g++) // Counting sort of the unopened GWs
+        if (!opened[g]) bucket[count[g] + 1]++;
+    for (uint c = 1; c < edCount + 2; c++)
+        bucket[c] += bucket[c - 1];
+    for (uint g = 0; g < gwCount; g++)
+        if (!opened[g]) {
+            position[g] = bucket[count[g]]++;
+            order[position[g]] = g;
+            active++;
+        }
+    for (uint c = edCount + 1; c > 0; c--) // Back to the first index of each bucket
+        bucket[c] = bucket[c - 1];
+    bucket[0] = 0;
+
+    while (assignedCount < edCount && active > 0) {
+        const uint g = order[--active]; // Max count
+        if (count[g] == 0) break; // Remaining EDs are out of range or capacity of every GW
+        open(g);
+    }
 
+    const bool feasibleFound = assignedCount == edCount;
+    if (verbose) {
+        std::cout << "GWs opened: " << gwOpened << std::endl;
+        std::cout << "EDs assigned: " << assignedCount << " (out of " << edCount << ")" << std::endl;
+    }
 
     OptimizationResults results;
 
-    results.cost = feasibleFound ? o->eval(gwBest, sfBest, results.gwUsed, results.energy, results.uf, results.feasible) : __DBL_MAX__;
+    results.cost = feasibleFound ? o->eval(gwBest.data(), sfBest.data(), results.gwUsed, results.energy, results.uf, results.feasible) : __DBL_MAX__;
+    if(wst && feasibleFound) o->exportWST(gwBest.data(), sfBest.data());
     results.tp = o->tp;
     results.execTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
     results.ready = true; // Set export flag to ready
@@ -91,7 +105,7 @@ OptimizationResults heuristica_rod(Instance* l, Objective* o, uint iters, uint t
         std::cout << "Optimization finished in " << results.execTime << " ms" << std::endl;
         if(feasibleFound){
             std::cout << "Best result:" << std::endl;
-            o->printSolution(gwBest, sfBest, true, true, true);
+            o->printSolution(gwBest.data(), sfBest.data(), true, true, true);
         }else{
             std::cout << "No feasible solution was found." << std::endl;
         }
@@ -9,9 +9,11 @@ OptimizationResults randomSearch(Instance* l, Objective* o, uint maxIters, uint
     if(verbose)
         std::cout << std::endl << "-------------- RS ----------------" << std::endl << std::endl;
 
-    // Optimization variable
-    uint* gw = (uint*) malloc( sizeof(uint) * l->edCount);
-    uint* sf = (uint*) malloc( sizeof(uint) * l->edCount);
+    // Optimization variable (a batch of candidates, one after the other)
+    const size_t edCount = l->edCount;
+    std::vector<uint> gw(RS_BATCH_SIZE*edCount);
+    std::vector<uint> sf(RS_BATCH_SIZE*edCount);
+    std::vector<EvalResults> batchResults(RS_BATCH_SIZE);
     // Best
     uint* gwBest = (uint*) malloc( sizeof(uint) * l->edCount);
     uint* sfBest = (uint*) malloc( sizeof(uint) * l->edCount);
@@ -26,27 +28,28 @@ OptimizationResults randomSearch(Instance* l, Objective* o, uint maxIters, uint
     if(verbose)
         std::cout << "Running " << maxIters << " iterations..." << std::endl << std::endl;
 
-    for(uint k = 0; k < maxIters; k++){ // For each iteration
-        // Generate a random solution (candidate)
-        for(uint i = 0; i < l->edCount; i++){
+    for(uint k = 0; k < maxIters; k += RS_BATCH_SIZE){ // For each batch of iterations
+        const uint batchSize = std::min(maxIters - k, (uint) RS_BATCH_SIZE);
+        // Generate random solutions (candidates)
+        for(size_t i = 0; i < batchSize*edCount; i++){
             gw[i] = gwGenerator.random();
             sf[i] = sfGenerator.random();
         }
-        // Test generated solution
-        uint gwCount, energy;
-        double totalUF;
-        bool feasible;
-        const double q = o->eval(gw, sf, gwCount, energy, totalUF, feasible);
-
-        if(feasible && q < bestQ){ // New optimum
-            bestQ = q;
-            found = true;
-            std::copy(gw, gw + l->edCount, gwBest);
-            std::copy(sf, sf + l->edCount, sfBest);
-            if(verbose){
-                std::cout << "New best at iteration: " << k << std::endl;
-                o->printSolution(gw, sf, false);
-                std::cout << std::endl << std::endl;
+        // Test generated solutions
+        o->evalBatch(batchSize, gw.data(), sf.data(), batchResults.data());
+
+        for(uint j = 0; j < batchSize; j++){
+            const double q = batchResults[j].cost;
+            if(batchResults[j].feasible && q < bestQ){ // New optimum
+                bestQ = q;
+                found = true;
+                std::copy(&gw[j*edCount], &gw[j*edCount] + edCount, gwBest);
+                std::copy(&sf[j*edCount], &sf[j*edCount] + edCount, sfBest);
+                if(verbose){
+                    std::cout << "New best at iteration: " << k + j << std::endl;
+                    o->printSolution(&gw[j*edCount], &sf[j*edCount], false);
+                    std::cout << std::endl << std::endl;
+                }
             }
         }
 
@@ -81,8 +84,6 @@ OptimizationResults randomSearch(Instance* l, Objective* o, uint maxIters, uint
     }
 
     // Release memory
-    free(gw);
-    free(sf);
     free(gwBest);
     free(sfBest);
 
@@ -96,9 +97,11 @@ OptimizationResults improvedRandomSearch(Instance* l, Objective* o, uint maxIter
     if(verbose)
         std::cout << std::endl << "-------------- IRS ---------------" << std::endl << std::endl;
 
-    // Optimization variable
-    uint* gw = (uint*) malloc( sizeof(uint) * l->edCount);
-    uint* sf = (uint*) malloc( sizeof(uint) * l->edCount);
+    // Optimization variable (a batch of candidates, one after the other)
+    const size_t edCount = l->edCount;
+    std::vector<uint> gw(RS_BATCH_SIZE*edCount);
+    std::vector<uint> sf(RS_BATCH_SIZE*edCount);
+    std::vector<EvalResults> batchResults(RS_BATCH_SIZE);
     // Best
     uint* gwBest = (uint*) malloc( sizeof(uint) * l->edCount);
     uint* sfBest = (uint*) malloc( sizeof(uint) * l->edCount);
@@ -111,31 +114,36 @@ OptimizationResults improvedRandomSearch(Instance* l, Objective* o, uint maxIter
     if(verbose)
         std::cout << "Running " << maxIters << " iterations..." << std::endl << std::endl;
 
-    for(uint k = 0; k < maxIters; k++){ // For each iteration
-        // Generate a random solution (candidate)
-        for(uint i = 0; i < l->edCount; i++){
-            std::vector<uint> gwList = l->getGWList(i); // Valid gw for this ed
-            gw[i] = gwList[(uint)floor(uniform.random()*gwList.size())]; // Pick random gw
-            // Pick random SF from valid range
-            const uint minSF = l->getMinSF(i, gw[i]);
-            const uint maxSF = l->getMaxSF(i);
-            sf[i] = uniform.random()*(maxSF - minSF) + minSF;
+    for(uint k = 0; k < maxIters; k += RS_BATCH_SIZE){ // For each batch of iterations
+        const uint batchSize = std::min(maxIters - k, (uint) RS_BATCH_SIZE);
+        // Generate random solutions (candidates)
+        for(uint j = 0; j < batchSize; j++){
+            uint* gwj = &gw[j*edCount];
+            uint* sfj = &sf[j*edCount];
+            for(uint i = 0; i < l->edCount; i++){
+                const IndexSpan gwList = l->getGWSpan(i); // Valid gw for this ed
+                gwj[i] = gwList[(uint)floor(uniform.random()*gwList.size())]; // Pick random gw
+                // Pick random SF from valid range
+                const uint minSF = l->getMinSF(i, gwj[i]);
+                const uint maxSF = l->getMaxSF(i);
+                sfj[i] = uniform.random()*(maxSF - minSF) + minSF;
+            }
         }
-        // Test generated solution
-        uint gwCount, energy;
-        double totalUF;
-        bool feasible;
-        const double q = o->eval(gw, sf, gwCount, energy, totalUF, feasible);
-
-        if(feasible && q < bestQ){ // New optimum
-            bestQ = q;
-            found = true;
-            std::copy(gw, gw + l->edCount, gwBest);
-            std::copy(sf, sf + l->edCount, sfBest);
-            if(verbose){
-                std::cout << "New best at iteration: " << k << std::endl;
-                o->printSolution(gw, sf, false);
-                std::cout << std::endl;
+        // Test generated solutions
+        o->evalBatch(batchSize, gw.data(), sf.data(), batchResults.data());
+
+        for(uint j = 0; j < batchSize; j++){
+            const double q = batchResults[j].cost;
+            if(batchResults[j].feasible && q < bestQ){ // New optimum
+                bestQ = q;
+                found = true;
+                std::copy(&gw[j*edCount], &gw[j*edCount] + edCount, gwBest);
+                std::copy(&sf[j*edCount], &sf[j*edCount] + edCount, sfBest);
+                if(verbose){
+                    std::cout << "New best at iteration: " << k + j << std::endl;
+                    o->printSolution(&gw[j*edCount], &sf[j*edCount], false);
+                    std::cout << std::endl;
+                }
             }
         }
 
@@ -170,8 +178,6 @@ OptimizationResults improvedRandomSearch(Instance* l, Objective* o, uint maxIter
     }
 
     // Release memory
-    free(gw);
-    free(sf);
     free(gwBest);
     free(sfBest);
 
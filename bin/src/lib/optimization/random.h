@@ -4,11 +4,14 @@
 #include <chrono>
 #include <vector>
 #include <math.h>
+#include <algorithm>
 #include "../util/util.h"
 #include "../random/uniform.h"
 #include "../model/instance.h"
 #include "../model/objective.h"
 
+#define RS_BATCH_SIZE 64 // Candidates generated and evaluated together
+
 OptimizationResults randomSearch(Instance* l, Objective* o, uint maxIters, uint timeout, bool verbose = false, bool wst = false);
 OptimizationResults improvedRandomSearch(Instance* l, Objective* o, uint maxIters, uint timeout, bool verbose = false, bool wst = false);
 
@@ -0,0 +1,159 @@
+#include <set>
+#include "greedy.h"
+
+#define REALLOCATION_MIN_IMPROVEMENT 1e-9 // Smaller cost changes are rounding errors, they could make moves cycle
+#define NOT_QUEUED ((uint) -1)
+
+class Reallocation { // State of the local search: allocation, incremental cost, exact GW loads and EDs of each GW
+    public:
+        Reallocation(Instance* l, Objective* o, uint* gw, uint* sf);
+
+        inline bool isFeasible() const {return this->cost.isFeasible();};
+        void getOrder(std::vector<uint>& order) const; // Used GWs, least loaded first
+        bool close(uint g); // Moves all EDs of g to other used GWs, if the cost improves
+        uint lowerSF(uint g); // Moves EDs of g to used GWs where they have a lower SF, while the cost improves
+
+    private:
+        Instance* l;
+        uint* gw;
+        uint* sf;
+        IncrementalEval cost;
+        GatewayLoad load;
+        std::vector<std::vector<uint>> edsOfGW;
+        std::vector<uint> position; // Index of each ED in the list of its GW
+        std::set<std::pair<uint, uint>> queue; // (ED count, GW) of used GWs
+        std::vector<uint> queuedCount; // ED count of each GW in queue (NOT_QUEUED if not used)
+        std::vector<std::pair<uint, uint>> undo; // (ED, SF) moved out of the GW being closed
+
+        void relocate(uint e, uint g, uint s);
+        void updateQueue(uint g); // O(log G) instead of sorting the GWs again
+};
+
+Reallocation::Reallocation(Instance* l, Objective* o, uint* gw, uint* sf) : cost(o) {
+    this->l = l;
+    this->gw = gw;
+    this->sf = sf;
+    this->cost.reset(gw, sf);
+    this->load = GatewayLoad(l->gwCount);
+    this->edsOfGW.resize(l->gwCount);
+    this->position.resize(l->edCount);
+    this->queuedCount.assign(l->gwCount, NOT_QUEUED);
+    for(uint e = 0; e < l->edCount; e++){
+        this->load.add(gw[e], sf[e], l->getUFFixed(e, sf[e]));
+        this->position[e] = this->edsOfGW[gw[e]].size();
+        this->edsOfGW[gw[e]].push_back(e);
+    }
+    for(uint g = 0; g < l->gwCount; g++)
+        this->updateQueue(g);
+}
+
+void Reallocation::updateQueue(uint g) {
+    if(this->queuedCount[g] != NOT_QUEUED)
+        this->queue.erase({this->queuedCount[g], g});
+    if(this->edsOfGW[g].empty()){
+        this->queuedCount[g] = NOT_QUEUED;
+    }else{
+        this->queuedCount[g] = this->edsOfGW[g].size();
+        this->queue.insert({this->queuedCount[g], g});
+    }
+}
+
+void Reallocation::getOrder(std::vector<uint>& order) const {
+    order.clear();
+    for(const std::pair<uint, uint>& item : this->queue)
+        order.push_back(item.second);
+}
+
+void Reallocation::relocate(uint e, uint g, uint s) { // Unvalidated move
+    const uint prevGW = this->gw[e];
+    std::vector<uint>& prevEDs = this->edsOfGW[prevGW];
+    this->load.sub(prevGW, this->sf[e], this->l->getUFFixed(e, this->sf[e]));
+    this->load.add(g, s, this->l->getUFFixed(e, s));
+    this->cost.move(e, g, s);
+    prevEDs[this->position[e]] = prevEDs.back(); // Remove from previous GW list
+    this->position[prevEDs.back()] = this->position[e];
+    prevEDs.pop_back();
+    this->position[e] = this->edsOfGW[g].size();
+    this->edsOfGW[g].push_back(e);
+    this->gw[e] = g;
+    this->sf[e] = s;
+    this->updateQueue(prevGW);
+    this->updateQueue(g);
+}
+
+bool Reallocation::close(uint g) {
+    const double prevCost = this->cost.getCost();
+    this->undo.clear();
+    while(!this->edsOfGW[g].empty()){
+        const uint e = this->edsOfGW[g].back();
+        bool moved = false;
+        for(uint g2 : this->l->getGWSpan(e)){ // Lowest SF first
+            const uint s = this->l->getMinSF(e, g2);
+            if(g2 != g && !this->edsOfGW[g2].empty() && s <= this->l->getMaxSF(e) && this->load.canTake(g2, s, this->l->getUFFixed(e, s))){
+                this->undo.push_back({e, this->sf[e]});
+                this->relocate(e, g2, s);
+                moved = true;
+                break;
+            }
+        }
+        if(!moved) break;
+    }
+    if(this->edsOfGW[g].empty() && this->cost.getCost() < prevCost - REALLOCATION_MIN_IMPROVEMENT)
+        return true;
+    for(size_t i = this->undo.size(); i > 0; i--) // Restore in reverse order, loads are exact
+        this->relocate(this->undo[i-1].first, g, this->undo[i-1].second);
+    return false;
+}
+
+uint Reallocation::lowerSF(uint g) {
+    uint moves = 0;
+    for(size_t i = 0; i < this->edsOfGW[g].size(); i++){
+        const uint e = this->edsOfGW[g][i];
+        const double prevCost = this->cost.getCost();
+        for(uint g2 : this->l->getGWSpan(e)){ // Lowest SF first
+            const uint s = this->l->getMinSF(e, g2);
+            if(s >= this->sf[e]) break; // Following GWs do not lower the SF
+            if(g2 != g && !this->edsOfGW[g2].empty() && this->load.canTake(g2, s, this->l->getUFFixed(e, s)) &&
+                    this->cost.moveCost(e, g2, s) < prevCost - REALLOCATION_MIN_IMPROVEMENT){
+                this->relocate(e, g2, s);
+                moves++;
+                i--; // Last ED of the list took the place of e
+                break;
+            }
+        }
+    }
+    return moves;
+}
+
+uint reallocate(Instance* l, Objective* o, uint* gw, uint* sf, bool verbose) {
+    Reallocation state(l, o, gw, sf);
+    if(!state.isFeasible()) return 0; // Moves keep the allocation feasible, they need a feasible start
+
+    uint moves = 0;
+    uint closed = 0;
+    uint passes = 0;
+    std::vector<uint> order;
+    bool improved = true;
+    while(improved){ // Until no move improves the cost
+        improved = false;
+        passes++;
+        state.getOrder(order);
+        for(uint g : order){ // Lower SFs first, closing GWs early leaves less room for it
+            const uint lowered = state.lowerSF(g);
+            moves += lowered;
+            improved |= lowered > 0;
+        }
+        if(improved) continue;
+        state.getOrder(order);
+        for(uint g : order){
+            if(state.close(g)){
+                closed++;
+                improved = true;
+                if(verbose) std::cout << "Closed GW " << g << std::endl;
+            }
+        }
+    }
+    if(verbose)
+        std::cout << "Reallocation: " << closed << " GWs closed and " << moves << " EDs moved to a lower SF in " << passes << " passes" << std::endl;
+    return moves + closed;
+}
@@ -5,6 +5,8 @@ Instance* _lt;
 Objective* _ot;
 Uniform uniform = Uniform(0.0, 1.0);
 uint ED_COUNT = 0;
+IncrementalEval* _et = nullptr; // Holds the last evaluated configuration
+std::vector<float> _lastSol;
 
 // Conversion functions
 void sol2gwsf(float sol, uint &gw, uint &sf) {
@@ -51,31 +53,14 @@ void init_g4(float* sol) {
     const uint edCount = _lt->edCount;
 
     double minimumCost = __DBL_MAX__;
-    std::vector<std::vector<std::vector<uint>>> clusters; // Clusters tensor (SF x GW x ED)
-    clusters.resize(6); // Initialize list of matrices (GW x ED)
+    const ClusterIndex& clusters = _lt->getClusters(); // Clusters tensor (SF x GW x ED) as bitsets
     for(uint s = 7; s <= 12; s++){
         
-        // Build cluster matrix for this SF
-        for(uint g = 0; g < gwCount; g++)
-            clusters[s-7].push_back(_lt->getAllEDList(g ,s));
-        
         // Check if SF has coverage
-        bool hasCoverage = true; // This is updated if an ED cannot be assigned to any GW
-        for(uint e = 0; e < edCount; e++){
-            bool hasGW = false;
-            for(uint g = 0; g < gwCount; g++){
-                auto it = std::find(clusters[s-7][g].begin(), clusters[s-7][g].end(), e);
-                hasGW = (it != clusters[s-7][g].end());
-                if(hasGW) break;
-            }
-            if(!hasGW){ 
-                hasCoverage = false;
-                if(s == 12) {
-                    std::cout << "Cannot reach coverage" << std::endl;
-                    exit(1);
-                }
-                break;
-            }
+        const bool hasCoverage = clusters.firstUncovered(s) == edCount; // Every ED can be assigned to some GW
+        if(!hasCoverage && s == 12){
+            std::cout << "Cannot reach coverage" << std::endl;
+            exit(1);
         }
 
         if(!hasCoverage) continue; // Next SF
@@ -101,8 +86,7 @@ void init_g4(float* sol) {
                     for(uint gi = 0; gi < gwCount; gi++){
                         const uint g = gwList[gi];
                         // Check if ED e can be connected to GW g
-                        auto it = std::find(clusters[s-7][g].begin(), clusters[s-7][g].end(), e);
-                        if((it != clusters[s-7][g].end()) && !gwuf[g].isFull()){
+                        if(clusters.contains(g, s, e) && !gwuf[g].isFull()){
                             uint minsf = _lt->getMinSF(e, g);
                             gw[e] = g;
                             sf[e] = minsf; // Always assign lower SF
@@ -132,18 +116,17 @@ void init_g4(float* sol) {
 double Etsp(void *xp) { // Energy computation
     float *sol = (float*) xp;
 
-    uint gwCount, energy;
-    double totalUF;
-	bool feasible;
-
-    uint gw[ED_COUNT];
-    uint sf[ED_COUNT];
+    // Configurations differ from the last evaluated one in a few EDs, so only those are moved
+    uint gw, sf;
     for(uint i = 0; i < ED_COUNT; i++)
-        sol2gwsf(sol[i], gw[i], sf[i]);
-    _ot->eval(gw, sf, gwCount, energy, totalUF, feasible);
+        if(sol[i] != _lastSol[i]){
+            sol2gwsf(sol[i], gw, sf);
+            _et->move(i, gw, sf);
+            _lastSol[i] = sol[i];
+        }
 
     // Return cost
-    return _ot->tp.alpha * gwCount + _ot->tp.beta * energy + _ot->tp.gamma * totalUF; 
+    return _ot->tp.alpha * _et->getGWUsed() + _ot->tp.beta * _et->getEnergy() + _ot->tp.gamma * _et->getMaxUF(); 
 }
 
 bool areEqual(float a, float b, float epsilon = 1e-5) {
@@ -202,7 +185,19 @@ OptimizationResults siman(Instance* l, Objective* o, uint iters, bool verbose, b
     
     gsl_siman_params_t params = {N_TRIES, ITERS_FIXED, STEP_SIZE, K, T_INITIAL, MU_T, T_MIN};
 
+    { // Evaluator starts from the initial configuration
+        uint gw[ED_COUNT];
+        uint sf[ED_COUNT];
+        for(uint i = 0; i < ED_COUNT; i++)
+            sol2gwsf(x_best[i], gw[i], sf[i]);
+        _et = new IncrementalEval(o);
+        _et->reset(gw, sf);
+        _lastSol.assign(x_best, x_best + ED_COUNT);
+    }
+
     gsl_siman_solve(r, x_best, Etsp, Stsp, Mtsp, Ptsp, NULL, NULL, NULL, ED_COUNT*sizeof(float), params);
+    delete _et;
+    _et = nullptr;
 
     // Eval best and export results
     OptimizationResults results;
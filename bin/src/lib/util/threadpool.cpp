@@ -0,0 +1,73 @@
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(uint threadCount) {
+    if(threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    this->task = nullptr;
+    this->count = 0;
+    this->next = 0;
+    this->activeWorkers = 0;
+    this->generation = 0;
+    this->stopping = false;
+    for(uint i = 1; i < threadCount; i++) // Calling thread is the last worker
+        this->workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        this->stopping = true;
+    }
+    this->startCV.notify_all();
+    for(std::thread& worker : this->workers)
+        worker.join();
+}
+
+ThreadPool& ThreadPool::getDefault() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::runIterations() {
+    for(uint i = this->next++; i < this->count; i = this->next++)
+        (*this->task)(i);
+}
+
+void ThreadPool::workerLoop() {
+    uint seenGeneration = 0;
+    while(true){
+        {
+            std::unique_lock<std::mutex> lock(this->stateMutex);
+            this->startCV.wait(lock, [&] {return this->stopping || this->generation != seenGeneration;});
+            if(this->stopping) return;
+            seenGeneration = this->generation;
+        }
+        this->runIterations();
+        {
+            std::lock_guard<std::mutex> lock(this->stateMutex);
+            this->activeWorkers--;
+        }
+        this->doneCV.notify_one();
+    }
+}
+
+void ThreadPool::parallelFor(uint count, const std::function<void(uint)>& task) {
+    if(this->workers.empty() || count <= 1){ // Nothing to share
+        for(uint i = 0; i < count; i++)
+            task(i);
+        return;
+    }
+    std::lock_guard<std::mutex> loopLock(this->loopMutex);
+    {
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        this->task = &task;
+        this->count = count;
+        this->next = 0;
+        this->activeWorkers = this->workers.size();
+        this->generation++;
+    }
+    this->startCV.notify_all();
+    this->runIterations();
+    std::unique_lock<std::mutex> lock(this->stateMutex);
+    this->doneCV.wait(lock, [&] {return this->activeWorkers == 0;});
+}
@@ -0,0 +1,48 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+/*
+    Class ThreadPool: Fixed set of worker threads used to run the iterations of parallel loops.
+    Workers are created once and wait for new loops, so short loops do not pay thread creation.
+*/
+
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+#include "util.h"
+
+class ThreadPool {
+    public:
+        ThreadPool(uint threadCount = 0); // 0 means one thread for each hardware thread
+        ~ThreadPool();
+
+        // Runs task(i) for i in [0, count) and returns when all of them finished. The calling thread also runs tasks.
+        // Tasks must not call parallelFor
+        void parallelFor(uint count, const std::function<void(uint)>& task);
+        inline uint getThreadCount() const {return this->workers.size() + 1;};
+
+        static ThreadPool& getDefault(); // Shared pool, created on first use
+
+    private:
+        std::vector<std::thread> workers;
+        std::mutex loopMutex; // Only one loop at a time
+        std::mutex stateMutex;
+        std::condition_variable startCV;
+        std::condition_variable doneCV;
+        const std::function<void(uint)>* task;
+        uint count;
+        std::atomic<uint> next; // Next iteration to run
+        uint activeWorkers; // Workers still running iterations of the current loop
+        uint generation; // Incremented for each loop, so workers know there is work
+        bool stopping;
+
+        void workerLoop();
+        void runIterations();
+};
+
+#endif // THREADPOOL_H
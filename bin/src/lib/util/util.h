@@ -5,6 +5,8 @@
 #include <vector>
 #include <fstream>
 #include <cstring>
+#include <cstdio>
+#include <csignal>
 #include <math.h>
 
 //using uint = unsigned int; // Just for shorten the code
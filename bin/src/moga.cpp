@@ -197,8 +197,12 @@ int main(int argc, char **argv) {
         std::vector<Ed> network; // List of nodes
         std::vector<std::vector<Ed>> pop; // List of network configurations
         std::string input;
+        bool streamed = false; // Input from "greedy --stream", the population can start before the stream ends
         while(std::cin >> input) {
-            if(input != "--"){
+            if(input[0] == '#'){ // Header of a streamed solution
+                streamed = true;
+                std::getline(std::cin, input);
+            }else if(input != "--"){
                 unsigned int gw = std::stoi(input);
                 unsigned int sf;
                 std::cin >> sf;
@@ -207,6 +211,10 @@ int main(int argc, char **argv) {
             }else{
                 pop.push_back(network);
                 network.clear();
+                if(streamed && pop.size() >= config->populationSize){
+                    std::fclose(stdin); // Writer stops streaming instead of blocking on a full pipe
+                    break;
+                }
             }
         }
 
@@ -257,8 +257,12 @@ int main(int argc, char **argv) {
         if(outputFormat != OUTPUTFORMAT::CSV)
             std::cout << "Reading population..." << std::endl;
         unsigned int popsize = 0;
+        bool streamed = false; // Input from "greedy --stream", the population can start before the stream ends
         while(std::cin >> input) {
-            if(input != "--"){
+            if(input[0] == '#'){ // Header of a streamed solution
+                streamed = true;
+                std::getline(std::cin, input);
+            }else if(input != "--"){
                 unsigned int gw = std::stoi(input);
                 unsigned int sf;
                 std::cin >> sf;
@@ -268,6 +272,10 @@ int main(int argc, char **argv) {
                 popsize++;
                 pop.push_back(network);
                 network.clear();
+                if(streamed && pop.size() >= config->populationSize){
+                    std::fclose(stdin); // Writer stops streaming instead of blocking on a full pipe
+                    break;
+                }
             }
         }
         if(outputFormat != OUTPUTFORMAT::CSV)
@@ -300,6 +308,7 @@ int main(int argc, char **argv) {
             Chromosome *chr = population[i];
             // Evaluate fitness
             ga->getFitnessFunction()->evaluate(chr);
+            ga->getFitnessFunction()->evaluateObjectives(chr);
 
             // print chr->objectives (comma separated std::vector<double> values)
             std::ofstream myfile;